@@ -59,6 +59,7 @@ void QImageWidgetImplementation::commonInit()
 	connect( m_ViewerCore, SIGNAL( emitZoomChanged( float ) ), this, SLOT( setZoom( float ) ) );
 	connect( m_ViewerCore, SIGNAL( emitShowLabels( bool ) ), this, SLOT( setShowLabels( bool ) ) );
 	connect( m_ViewerCore, SIGNAL( emitSetEnableCrosshair( bool ) ), this, SLOT( setEnableCrosshair( bool ) ) );
+	connect( m_ViewerCore, SIGNAL( emitPrefetchTimesteps( int, int ) ), this, SLOT( prefetchSlices( int, int ) ) );
 	setAutoFillBackground( true );
 	setPalette( QPalette( Qt::black ) );
 	m_LeftMouseButtonPressed = false;
@@ -75,6 +76,9 @@ void QImageWidgetImplementation::commonInit()
 	translationX = 0.0;
 	translationY = 0.0;
 	m_ShowCrosshair = true;
+	m_ForceRepaint = true;
+	m_PaintedCurrentImage = 0;
+	m_PaintedMode = m_ViewerCore->getMode();
 	m_CrosshairColor = QColor( 255, 102, 0 );
 	setAcceptDrops( true );
 	setFocus();
@@ -93,9 +97,15 @@ void QImageWidgetImplementation::addImage( const boost::shared_ptr< ImageHolder
 {
 	ImageProperties imgProperties;
 	imgProperties.viewPort = QOrientationHandler::ViewPortType();
+	imgProperties.sliceIndex = -1;
+	imgProperties.sliceTimestep = -1;
+	imgProperties.sliceRevision = 0;
+	imgProperties.sliceWindowLUTRevision = 0;
+	imgProperties.sliceOrientationRevision = 0;
 	m_ImageProperties.insert( std::make_pair< boost::shared_ptr<ImageHolder> , ImageProperties >( image, imgProperties ) );
 	m_ImageVector.push_back( image );
 	image->addWidget( this );
+	m_ForceRepaint = true;
 	setFocus();
 }
 
@@ -103,6 +113,7 @@ bool QImageWidgetImplementation::removeImage( const boost::shared_ptr< ImageHold
 {
 	image->removeWidget( this );
 	m_ImageProperties.erase( image );
+	m_ForceRepaint = true;
 	ImageVectorType::iterator iter = std::find( m_ImageVector.begin(), m_ImageVector.end(), image );
 
 	if( iter != m_ImageVector.end() ) {
@@ -146,6 +157,14 @@ void QImageWidgetImplementation::paintEvent( QPaintEvent */*event*/ )
 											m_Border
 										  );
 		boost::shared_ptr<ImageHolder> cImage =  getWidgetSpecCurrentImage();
+		ImageVectorType paintOrder;
+
+		BOOST_FOREACH( ImageVectorType::const_reference image, m_ImageVector ) {
+			m_ImageProperties.at( image ).paintState = getPaintState( image );
+		}
+		m_PaintedCurrentImage = cImage.get();
+		m_PaintedMode = m_ViewerCore->getMode();
+		m_ForceRepaint = false;
 
 		if( m_ViewerCore->getMode() == ViewerCoreBase::zmap ) {
 			//painting all anatomical images
@@ -153,13 +172,13 @@ void QImageWidgetImplementation::paintEvent( QPaintEvent */*event*/ )
 				if( image.get() != cImage.get()
 					&& image->isVisible
 					&& image->imageType == ImageHolder::structural_image ) {
-					paintImage( image );
+					paintOrder.push_back( image );
 				}
 			}
 
 			if( cImage->imageType == ImageHolder::structural_image
 				&& cImage->isVisible ) {
-				paintImage( cImage );
+				paintOrder.push_back( cImage );
 			}
 
 			//painting the zmaps
@@ -167,24 +186,42 @@ void QImageWidgetImplementation::paintEvent( QPaintEvent */*event*/ )
 				if( image.get() != cImage.get()
 					&& image->isVisible
 					&& image->imageType == ImageHolder::z_map ) {
-					paintImage( image );
+					paintOrder.push_back( image );
 				}
 			}
 
 			if( cImage->imageType == ImageHolder::z_map
 				&& cImage->isVisible ) {
-				paintImage( cImage );
+				paintOrder.push_back( cImage );
 			}
 		} else {
 			BOOST_FOREACH( ImageVectorType::const_reference image, m_ImageVector ) {
 				if( image.get() != cImage.get()
 					&& image->isVisible ) {
-					paintImage( image );
+					paintOrder.push_back( image );
 				}
 			}
 
 			if( cImage->isVisible ) {
-				paintImage( cImage );
+				paintOrder.push_back( cImage );
+			}
+		}
+
+		//images that are drawn with the same geometry are composed on the cpu and painted at once
+		ImageVectorType::const_iterator iter = paintOrder.begin();
+
+		while( iter != paintOrder.end() ) {
+			ImageVectorType group;
+			group.push_back( *iter );
+
+			while( ++iter != paintOrder.end() && hasSameGeometry( group.front(), *iter ) ) {
+				group.push_back( *iter );
+			}
+
+			if( group.size() == 1 ) {
+				paintImage( group.front() );
+			} else {
+				paintImages( group );
 			}
 		}
 
@@ -236,7 +273,7 @@ void QImageWidgetImplementation::recalculateTranslation()
 }
 
 
-void QImageWidgetImplementation::paintImage( boost::shared_ptr< ImageHolder > image )
+QImageWidgetImplementation::ImageProperties &QImageWidgetImplementation::prepareImagePainting( const boost::shared_ptr< ImageHolder > image )
 {
 	ImageProperties &imgProps = m_ImageProperties.at( image );
 
@@ -249,8 +286,6 @@ void QImageWidgetImplementation::paintImage( boost::shared_ptr< ImageHolder > im
 		break;
 	}
 
-	const util::ivector4 mappedSizeAligned = QOrientationHandler::mapCoordsToOrientation( image->alignedSize32, image, m_PlaneOrientation );
-
 	m_Painter->resetMatrix();
 
 	if( image.get() != getWidgetSpecCurrentImage().get() ) {
@@ -266,30 +301,184 @@ void QImageWidgetImplementation::paintImage( boost::shared_ptr< ImageHolder > im
 	imgProps.viewPort[3] += translationY;
 
 	m_Painter->setTransform( QOrientationHandler::getTransform( imgProps.viewPort, image, m_PlaneOrientation ) );
+	return imgProps;
+}
+
+void QImageWidgetImplementation::fillBorders( const ImageProperties &imgProps )
+{
+	//workaround to elimninate white edges
+	m_Painter->resetMatrix();
+	m_Painter->fillRect( imgProps.viewPort[4] + imgProps.viewPort[2] - ( m_InterpolationType ? 3 : 0 ) , 0, width(), height(), Qt::black );
+	m_Painter->fillRect( 0, imgProps.viewPort[5] + imgProps.viewPort[3] - ( m_InterpolationType ? 3 : 0 ), width(), height(), Qt::black );
+	m_Painter->fillRect( 0, 0, imgProps.viewPort[2], height(), Qt::black );
+}
 
+void QImageWidgetImplementation::paintImage( boost::shared_ptr< ImageHolder > image )
+{
+	ImageProperties &imgProps = prepareImagePainting( image );
 	m_Painter->setOpacity( image->opacity );
+	m_Painter->drawImage( 0, 0, getSlice( image, imgProps ) );
+	fillBorders( imgProps );
+}
+
+void QImageWidgetImplementation::paintImages( const ImageVectorType &images )
+{
+	const ImageProperties *groupProps = 0;
+	BOOST_FOREACH( ImageVectorType::const_reference image, images ) {
+		ImageProperties &imgProps = prepareImagePainting( image );
+		const QImage &slice = getSlice( image, imgProps );
+
+		if( !groupProps ) {
+			groupProps = &imgProps;
+			m_Compositor.begin( slice.width(), slice.height() );
+		}
+
+		m_Compositor.addSlice( slice, image->colorMap, image->opacity );
+	}
+	//all images share the same geometry, so the transform of the last one fits for the composed image
+	m_Painter->setOpacity( 1.0 );
+	m_Painter->drawImage( 0, 0, m_Compositor.getImage() );
+	fillBorders( *groupProps );
+}
+
+bool QImageWidgetImplementation::hasSameGeometry( const boost::shared_ptr< ImageHolder > first, const boost::shared_ptr< ImageHolder > second ) const
+{
+	for( unsigned short i = 0; i < 3; i++ ) {
+		if( first->getImageSize()[i] != second->getImageSize()[i] || first->voxelSize[i] != second->voxelSize[i] ) {
+			return false;
+		}
+
+		for( unsigned short j = 0; j < 3; j++ ) {
+			if( first->latchedOrientation( i, j ) != second->latchedOrientation( i, j ) ) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+const QImage &QImageWidgetImplementation::getSlice( const boost::shared_ptr< ImageHolder > image, ImageProperties &imgProps )
+{
+	const int32_t sliceIndex = QOrientationHandler::mapCoordsToOrientation( image->voxelCoords, image, m_PlaneOrientation )[2];
+	const int32_t timestep = image->voxelCoords[3];
+
+	//zooming, panning and crosshair movements within this plane do not change the slice, so we can reuse the last one
+	if( imgProps.slice.isNull()
+		|| imgProps.sliceIndex != sliceIndex
+		|| imgProps.sliceTimestep != timestep
+		|| imgProps.sliceWindowLUTRevision != image->getWindowLUTRevision()
+		|| imgProps.sliceOrientationRevision != image->getOrientationRevision()
+		|| isSliceChanged( image, imgProps.sliceRevision ) ) {
+		PrefetchedSliceMapType::iterator prefetched = imgProps.prefetchedSlices.find( timestep );
+
+		if( prefetched != imgProps.prefetchedSlices.end()
+			&& prefetched->second.sliceIndex == sliceIndex
+			&& !isSliceChanged( image, prefetched->second.revision, sliceIndex, timestep )
+			&& prefetched->second.windowLUTRevision == image->getWindowLUTRevision()
+			&& prefetched->second.orientationRevision == image->getOrientationRevision()
+			&& prefetched->second.slice.isFinished() ) {
+			imgProps.slice = prefetched->second.slice.result();
+		} else {
+			extractSlice( imgProps.slice, image, m_PlaneOrientation, sliceIndex, timestep );
+		}
+
+		if( prefetched != imgProps.prefetchedSlices.end() ) {
+			imgProps.prefetchedSlices.erase( prefetched );
+		}
+
+		imgProps.sliceIndex = sliceIndex;
+		imgProps.sliceTimestep = timestep;
+		imgProps.sliceWindowLUTRevision = image->getWindowLUTRevision();
+		imgProps.sliceOrientationRevision = image->getOrientationRevision();
+	}
+
+	//changes of other slices do not affect this one, so it is up to date with the current revision
+	imgProps.sliceRevision = image->getDataRevision();
+
+	if( !image->isRGB ) {
+		imgProps.slice.setColorTable( image->colorMap );
+	}
+
+	return imgProps.slice;
+}
+
+void QImageWidgetImplementation::extractSlice( QImage &slice, const boost::shared_ptr< ImageHolder > image, const PlaneOrientation &orientation, const int32_t &sliceIndex, const int32_t &timestep, bool parallel )
+{
+	const util::ivector4 mappedSizeAligned = QOrientationHandler::mapCoordsToOrientation( image->alignedSize32, image, orientation );
 
 	if ( !image->isRGB ) {
-		isis::data::MemChunk<InternalImageType> sliceChunk( mappedSizeAligned[0], mappedSizeAligned[1] );
-		m_MemoryHandler.fillSliceChunk<InternalImageType>( sliceChunk, image, m_PlaneOrientation, image->voxelCoords[3] );
-		QImage qImage( ( InternalImageType * ) sliceChunk.asValuePtr<InternalImageType>().getRawAddress().get(),
-					   mappedSizeAligned[0], mappedSizeAligned[1], QImage::Format_Indexed8 );
-		qImage.setColorTable( image->colorMap );
-		m_Painter->drawImage( 0, 0, qImage );
+		if( slice.width() != mappedSizeAligned[0] || slice.height() != mappedSizeAligned[1] || slice.format() != QImage::Format_Indexed8 ) {
+			slice = QImage( mappedSizeAligned[0], mappedSizeAligned[1], QImage::Format_Indexed8 );
+		}
+
+		if( image->isHighPrecision() ) {
+			QMemoryHandler::fillWindowedSlice( slice.bits(), slice.bytesPerLine(), mappedSizeAligned[1], image, orientation, timestep, sliceIndex, parallel );
+		} else {
+			QMemoryHandler::fillSlice<InternalImageType>( slice.bits(), slice.bytesPerLine() / sizeof( InternalImageType ),
+					mappedSizeAligned[1], image, orientation, timestep, sliceIndex, parallel );
+		}
 	} else {
-		isis::data::MemChunk<InternalImageColorType> sliceChunk( mappedSizeAligned[0], mappedSizeAligned[1] );
-		m_MemoryHandler.fillSliceChunk<InternalImageColorType>( sliceChunk, image, m_PlaneOrientation, image->voxelCoords[3] );
-		QImage qImage( ( InternalImageType * ) sliceChunk.asValuePtr<InternalImageColorType>().getRawAddress().get(),
-					   mappedSizeAligned[0], mappedSizeAligned[1], QImage::Format_RGB888 );
-		m_Painter->drawImage( 0, 0, qImage );
+		if( slice.width() != mappedSizeAligned[0] || slice.height() != mappedSizeAligned[1] || slice.format() != QImage::Format_RGB888 ) {
+			slice = QImage( mappedSizeAligned[0], mappedSizeAligned[1], QImage::Format_RGB888 );
+		}
 
+		QMemoryHandler::fillSlice<InternalImageColorType>( reinterpret_cast<InternalImageColorType *>( slice.bits() ), slice.bytesPerLine() / sizeof( InternalImageColorType ),
+				mappedSizeAligned[1], image, orientation, timestep, sliceIndex, parallel );
 	}
+}
 
-	//workaround to elimninate white edges
-	m_Painter->resetMatrix();
-	m_Painter->fillRect( imgProps.viewPort[4] + imgProps.viewPort[2] - ( m_InterpolationType ? 3 : 0 ) , 0, width(), height(), Qt::black );
-	m_Painter->fillRect( 0, imgProps.viewPort[5] + imgProps.viewPort[3] - ( m_InterpolationType ? 3 : 0 ), width(), height(), Qt::black );
-	m_Painter->fillRect( 0, 0, imgProps.viewPort[2], height(), Qt::black );
+QImage QImageWidgetImplementation::createSlice( const boost::shared_ptr< ImageHolder > image, PlaneOrientation orientation, int32_t sliceIndex, int32_t timestep )
+{
+	//runs on a pool thread next to the other prefetches, so it does not start OpenMP threads of its own
+	QImage slice;
+	extractSlice( slice, image, orientation, sliceIndex, timestep, false );
+	return slice;
+}
+
+void QImageWidgetImplementation::prefetchSlices( int timestep, int count )
+{
+	BOOST_FOREACH( ImageVectorType::const_reference image, m_ImageVector ) {
+		const int nTimesteps = image->getImageSize()[3];
+
+		if( !image->isVisible || nTimesteps < 2 ) {
+			continue;
+		}
+
+		ImageProperties &imgProps = m_ImageProperties.at( image );
+		const int32_t sliceIndex = QOrientationHandler::mapCoordsToOrientation( image->voxelCoords, image, m_PlaneOrientation )[2];
+		const int window = std::min( count, nTimesteps - 1 );
+
+		//forget about slices that are behind us
+		for( PrefetchedSliceMapType::iterator iter = imgProps.prefetchedSlices.begin(); iter != imgProps.prefetchedSlices.end(); ) {
+			const int distance = ( iter->first - timestep + nTimesteps ) % nTimesteps;
+
+			if( distance == 0 || distance > window ) {
+				imgProps.prefetchedSlices.erase( iter++ );
+			} else {
+				++iter;
+			}
+		}
+
+		for( int i = 1; i <= window; i++ ) {
+			const int32_t t = ( timestep + i ) % nTimesteps;
+			PrefetchedSliceMapType::const_iterator prefetched = imgProps.prefetchedSlices.find( t );
+
+			if( prefetched == imgProps.prefetchedSlices.end()
+				|| prefetched->second.sliceIndex != sliceIndex
+				|| isSliceChanged( image, prefetched->second.revision, sliceIndex, t )
+				|| prefetched->second.windowLUTRevision != image->getWindowLUTRevision()
+				|| prefetched->second.orientationRevision != image->getOrientationRevision() ) {
+				PrefetchedSlice &entry = imgProps.prefetchedSlices[t];
+				entry.sliceIndex = sliceIndex;
+				entry.revision = image->getDataRevision();
+				entry.windowLUTRevision = image->getWindowLUTRevision();
+				entry.orientationRevision = image->getOrientationRevision();
+				entry.slice = QtConcurrent::run( &QImageWidgetImplementation::createSlice, image, m_PlaneOrientation, sliceIndex, t );
+			}
+		}
+	}
 }
 
 
@@ -435,13 +624,10 @@ void QImageWidgetImplementation::paintCrosshair() const
 
 }
 
-void QImageWidgetImplementation::lookAtPhysicalCoords( const isis::util::fvector4 &physicalCoords )
+void QImageWidgetImplementation::lookAtPhysicalCoords( const isis::util::fvector4 &/*physicalCoords*/ )
 {
-	BOOST_FOREACH( DataContainer::reference image, m_ViewerCore->getDataContainer() ) {
-		image.second->physicalCoords = physicalCoords;
-		image.second->voxelCoords = image.second->getISISImage()->getIndexFromPhysicalCoords( physicalCoords, true );
-	}
-	update();
+	//the voxel coords of the images were already updated by the viewer core
+	updateScene();
 }
 
 void QImageWidgetImplementation::mouseReleaseEvent( QMouseEvent *e )
@@ -478,7 +664,72 @@ void QImageWidgetImplementation::wheelEvent( QWheelEvent *e )
 
 void QImageWidgetImplementation::updateScene()
 {
-	update();
+	if( needsRepaint() ) {
+		update();
+	}
+}
+
+QImageWidgetImplementation::PaintState QImageWidgetImplementation::getPaintState( const boost::shared_ptr< ImageHolder > image ) const
+{
+	PaintState state;
+	state.mappedCoords = QOrientationHandler::mapCoordsToOrientation( image->voxelCoords, image, m_PlaneOrientation );
+
+	//without crosshair and zooming only the slice and the timestep are visible in this plane
+	if( !m_ShowCrosshair && currentZoom == 1 ) {
+		state.mappedCoords[0] = 0;
+		state.mappedCoords[1] = 0;
+	}
+
+	state.mappedCoords[3] = image->voxelCoords[3];
+	state.dataRevision = image->getDataRevision();
+	state.colorMapRevision = image->getColorMapRevision();
+	state.windowLUTRevision = image->getWindowLUTRevision();
+	state.orientationRevision = image->getOrientationRevision();
+	state.opacity = image->opacity;
+	state.isVisible = image->isVisible;
+	state.imageType = image->imageType;
+	return state;
+}
+
+bool QImageWidgetImplementation::isSliceChanged( const boost::shared_ptr< ImageHolder > image, const size_t &revision ) const
+{
+	const unsigned short axis = image->getOrientationMapping( m_PlaneOrientation ).axis[2];
+	return isSliceChanged( image, revision, image->voxelCoords[axis], image->voxelCoords[3] );
+}
+
+bool QImageWidgetImplementation::isSliceChanged( const boost::shared_ptr< ImageHolder > image, const size_t &revision, const int32_t &sliceIndex, const int32_t &timestep ) const
+{
+	//the slice is the whole image except for the axis perpendicular to this plane and the time
+	const unsigned short axis = image->getOrientationMapping( m_PlaneOrientation ).axis[2];
+	const util::FixedVector<size_t, 4> size = image->getImageSize();
+	util::ivector4 start;
+	util::ivector4 end;
+
+	for( unsigned short i = 0; i < 3; i++ ) {
+		end[i] = size[i] - 1;
+	}
+
+	start[axis] = end[axis] = sliceIndex;
+	start[3] = end[3] = timestep;
+	return image->isVoxelDataChanged( revision, start, end );
+}
+
+bool QImageWidgetImplementation::needsRepaint() const
+{
+	if( m_ForceRepaint || m_ShowScalingOffset
+		|| ( m_ImageVector.size() && m_PaintedCurrentImage != getWidgetSpecCurrentImage().get() )
+		|| m_PaintedMode != m_ViewerCore->getMode() ) {
+		return true;
+	}
+
+	BOOST_FOREACH( ImageVectorType::const_reference image, m_ImageVector ) {
+		const PaintState &paintState = m_ImageProperties.at( image ).paintState;
+
+		if( !( paintState == getPaintState( image ) ) || isSliceChanged( image, paintState.dataRevision ) ) {
+			return true;
+		}
+	}
+	return false;
 }
 
 std::string QImageWidgetImplementation::getWidgetName() const
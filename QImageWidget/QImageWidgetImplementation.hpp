@@ -32,10 +32,13 @@
 #include <QWidget>
 #include <QPainter>
 #include <QtGui>
+#include <QFuture>
+#include <QtConcurrentRun>
 #include "widgetinterface.hpp"
 #include "qviewercore.hpp"
 #include "QMemoryHandler.hpp"
 #include "QOrientationHandler.hpp"
+#include "QSliceCompositor.hpp"
 #include "color.hpp"
 
 namespace isis
@@ -48,9 +51,50 @@ namespace viewer
 class QImageWidgetImplementation : public QWidget, public WidgetInterface
 {
 	Q_OBJECT
+	/**everything the painting of one image in this widget depends on**/
+	struct PaintState {
+		util::ivector4 mappedCoords;
+		/**not compared, changes of the voxel data are checked with isSliceChanged**/
+		size_t dataRevision;
+		size_t colorMapRevision;
+		size_t windowLUTRevision;
+		size_t orientationRevision;
+		float opacity;
+		bool isVisible;
+		ImageHolder::ImageType imageType;
+		bool operator==( const PaintState &other ) const {
+			return mappedCoords == other.mappedCoords
+				   && colorMapRevision == other.colorMapRevision
+				   && windowLUTRevision == other.windowLUTRevision
+				   && orientationRevision == other.orientationRevision
+				   && opacity == other.opacity
+				   && isVisible == other.isVisible
+				   && imageType == other.imageType;
+		}
+	};
+	/**slice of a following timestep that is extracted on a worker thread**/
+	struct PrefetchedSlice {
+		int32_t sliceIndex;
+		size_t revision;
+		size_t windowLUTRevision;
+		size_t orientationRevision;
+		QFuture<QImage> slice;
+	};
+	typedef std::map<int32_t, PrefetchedSlice> PrefetchedSliceMapType;
 	struct ImageProperties {
 		/**scaling, offset, size**/
 		isis::viewer::QOrientationHandler::ViewPortType viewPort;
+		/**last extracted slice and the slice index, timestep, data, window LUT and orientation revision it was extracted for**/
+		QImage slice;
+		int32_t sliceIndex;
+		int32_t sliceTimestep;
+		size_t sliceRevision;
+		size_t sliceWindowLUTRevision;
+		size_t sliceOrientationRevision;
+		/**state of the image at the time of the last paint**/
+		PaintState paintState;
+		/**prefetched slices by timestep**/
+		PrefetchedSliceMapType prefetchedSlices;
 	};
 	typedef std::map<boost::shared_ptr<ImageHolder>, ImageProperties> ImagePropertiesMapType;
 
@@ -60,7 +104,7 @@ public:
 
 public Q_SLOTS:
 
-	virtual void setEnableCrosshair( bool enable ) { m_ShowCrosshair = enable; }
+	virtual void setEnableCrosshair( bool enable ) { m_ShowCrosshair = enable; m_ForceRepaint = true; }
 
 	virtual void setZoom( float zoom );
 	virtual void addImage( const boost::shared_ptr<ImageHolder> image );
@@ -70,11 +114,13 @@ public Q_SLOTS:
 
 	virtual void lookAtPhysicalCoords( const util::fvector4 &physicalCoords );
 	virtual void updateScene();
-	virtual void setInterpolationType( InterpolationType interType ) { m_InterpolationType = interType; }
-	virtual void setShowLabels( bool show ) { m_ShowLabels = show; m_Border = show ? 18 : 0; }
+	///extracts the slices of the count timesteps following timestep on worker threads
+	virtual void prefetchSlices( int timestep, int count );
+	virtual void setInterpolationType( InterpolationType interType ) { m_InterpolationType = interType; m_ForceRepaint = true; }
+	virtual void setShowLabels( bool show ) { m_ShowLabels = show; m_Border = show ? 18 : 0; m_ForceRepaint = true; }
 	virtual void setMouseCursorIcon( QIcon icon );
-	virtual void setCrossHairColor( QColor color ) { m_CrosshairColor = color; }
-	virtual void setCrossHairWidth( int width ) { m_CrosshairWidth = width; }
+	virtual void setCrossHairColor( QColor color ) { m_CrosshairColor = color; m_ForceRepaint = true; }
+	virtual void setCrossHairWidth( int width ) { m_CrosshairWidth = width; m_ForceRepaint = true; }
 
 	virtual std::string getWidgetName() const;
 	virtual void setWidgetName( const std::string &wName );
@@ -105,11 +151,26 @@ private:
 
 	void emitMousePressEvent( QMouseEvent *e );
 	void recalculateTranslation();
+	const QImage &getSlice( const boost::shared_ptr<ImageHolder> image, ImageProperties &imgProps );
+	static void extractSlice( QImage &slice, const boost::shared_ptr<ImageHolder> image, const PlaneOrientation &orientation, const int32_t &sliceIndex, const int32_t &timestep, bool parallel = true );
+	static QImage createSlice( const boost::shared_ptr<ImageHolder> image, PlaneOrientation orientation, int32_t sliceIndex, int32_t timestep );
+	ImageProperties &prepareImagePainting( const boost::shared_ptr<ImageHolder> image );
+	void fillBorders( const ImageProperties &imgProps );
+	void paintImages( const ImageVectorType &images );
+	bool hasSameGeometry( const boost::shared_ptr<ImageHolder> first, const boost::shared_ptr<ImageHolder> second ) const;
+	PaintState getPaintState( const boost::shared_ptr<ImageHolder> image ) const;
+	///true if the voxel data of the slice shown for image has changed after revision
+	bool isSliceChanged( const boost::shared_ptr<ImageHolder> image, const size_t &revision ) const;
+	///true if the voxel data of the given slice and timestep has changed after revision
+	bool isSliceChanged( const boost::shared_ptr<ImageHolder> image, const size_t &revision, const int32_t &sliceIndex, const int32_t &timestep ) const;
+	///returns true if anything this widget displays has changed since the last paint
+	bool needsRepaint() const;
 	void showLabels() const ;
 
 	boost::shared_ptr<ImageHolder> getWidgetSpecCurrentImage() const;
 
 	QMemoryHandler m_MemoryHandler;
+	QSliceCompositor m_Compositor;
 
 	void commonInit();
 	util::PropertyMap m_WidgetProperties;
@@ -122,6 +183,9 @@ private:
 	bool m_RightMouseButtonPressed;
 	bool m_ShowScalingOffset;
 	bool m_ShowCrosshair;
+	bool m_ForceRepaint;
+	const ImageHolder *m_PaintedCurrentImage;
+	ViewerCoreBase::Mode m_PaintedMode;
 
 	float translationX;
 	float translationY;
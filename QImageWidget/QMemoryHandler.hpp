@@ -30,6 +30,7 @@
 
 #include "qviewercore.hpp"
 #include "QOrientationHandler.hpp"
+#include <algorithm>
 
 struct stat;
 namespace isis
@@ -44,26 +45,152 @@ public:
 
 	template< typename TYPE>
 	void fillSliceChunk( data::MemChunk<TYPE> &sliceChunk, const boost::shared_ptr< ImageHolder > image, const PlaneOrientation &orientation, const size_t &timestep = 0 ) const {
+		const util::FixedVector<size_t, 4> sliceSize = sliceChunk.getSizeAsVector();
+		fillSlice<TYPE>( static_cast<TYPE *>( static_cast<data::Chunk &>( sliceChunk ).asValuePtr<TYPE>().getRawAddress().get() ),
+						 sliceSize[0], sliceSize[1], image, orientation, timestep );
+	}
+
+	/**
+	 * Extracts the slice at the current voxelCoords of the image in the given orientation into dest.
+	 * If sliceIndex is not negative, this slice is extracted instead.
+	 * dest has to hold destWidth * destHeight elements (destWidth usually is the 32bit aligned row length).
+	 * The part of dest that is not covered by the slice is set to 0.
+	 * Flipping is not done here, this is handled by the transform of the painter.
+	 * If parallel is true the rows are extracted by all OpenMP threads. Callers that already run on a worker thread should pass false.
+	 */
+	template< typename TYPE>
+	static void fillSlice( TYPE *dest, const size_t &destWidth, const size_t &destHeight, const boost::shared_ptr< ImageHolder > image, const PlaneOrientation &orientation, const size_t &timestep = 0, const int32_t &sliceIndex = -1, bool parallel = true ) {
+		fillSlice<TYPE, TYPE>( dest, destWidth, destHeight, image, orientation, Copy<TYPE>(), timestep, sliceIndex, parallel );
+	}
+
+	/**
+	 * Extracts the slice like fillSlice, but the 16 bit values of an image with high precision are mapped to the 8 bit index of the colormap by its window LUT.
+	 */
+	static void fillWindowedSlice( uint8_t *dest, const size_t &destWidth, const size_t &destHeight, const boost::shared_ptr< ImageHolder > image, const PlaneOrientation &orientation, const size_t &timestep = 0, const int32_t &sliceIndex = -1, bool parallel = true ) {
+		const boost::shared_ptr<const ImageHolder::WindowLUTType> windowLUT = image->getWindowLUT();
+
+		if( !windowLUT ) {
+			clearBorder<uint8_t>( dest, destWidth, destHeight, 0, 0 );
+			return;
+		}
+
+		fillSlice<InternalImageHighPrecisionType, uint8_t>( dest, destWidth, destHeight, image, orientation, Window( &( *windowLUT )[0] ), timestep, sliceIndex, parallel );
+	}
+
+private:
+	QViewerCore *m_ViewerCore;
+
+	///edge length of the tiles used for the transposing extraction kernel
+	static const int32_t m_TileSize = 32;
+
+	template<typename TYPE>
+	struct Copy {
+		TYPE operator()( const TYPE &value ) const { return value; }
+	};
+	struct Window {
+		Window( const uint8_t *lut ) : m_LUT( lut ) {}
+		uint8_t operator()( const InternalImageHighPrecisionType &value ) const { return m_LUT[value]; }
+		const uint8_t *m_LUT;
+	};
+
+	///extracts the slice and converts every voxel with the functor convert
+	template< typename SRC, typename DEST, typename CONVERT>
+	static void fillSlice( DEST *dest, const size_t &destWidth, const size_t &destHeight, const boost::shared_ptr< ImageHolder > image, const PlaneOrientation &orientation, const CONVERT &convert, const size_t &timestep, const int32_t &sliceIndex, bool parallel ) {
 		const util::ivector4 mappedSize = QOrientationHandler::mapCoordsToOrientation( image->getImageSize(), image, orientation );
-		const util::ivector4 mappedCoords = QOrientationHandler::mapCoordsToOrientation( image->voxelCoords, image, orientation );
+		const int32_t slice = sliceIndex < 0 ? static_cast<int32_t>( QOrientationHandler::mapCoordsToOrientation( image->voxelCoords, image, orientation )[2] ) : sliceIndex;
 		const util::ivector4 mapping = QOrientationHandler::mapCoordsToOrientation( util::ivector4( 0, 1, 2, 3 ), image, orientation, true );
-		const data::Chunk chunk = image->getChunkVector()[timestep];
-		#pragma omp parallel for
+		const util::FixedVector<size_t, 4> &imageSize = image->getImageSize();
+		const size_t imageStrides[3] = { 1, imageSize[0], imageSize[0] * imageSize[1] };
+		size_t sliceStrides[3];
+
+		//image axis i is shown along axis mapping[i] of the slice
+		for( unsigned short i = 0; i < 3; i++ ) {
+			sliceStrides[mapping[i]] = imageStrides[i];
+		}
+
+		const int32_t width = std::min<int32_t>( mappedSize[0], destWidth );
+		const int32_t height = std::min<int32_t>( mappedSize[1], destHeight );
+		//holding the volume keeps its memory alive while we copy
+		data::Chunk volume = image->getVolume( timestep, parallel );
+
+		//the precision of the image was changed while we were extracting, the next paint gets the right type
+		if( volume.getTypeID() != data::ValuePtr<SRC>::staticID ) {
+			clearBorder<DEST>( dest, destWidth, destHeight, 0, 0 );
+			return;
+		}
+
+		const SRC *src = &volume.voxel<SRC>( 0, 0, 0 ) + slice * sliceStrides[2];
 
-		for ( int32_t y = 0; y < mappedSize[1]; y++ ) {
-			for ( int32_t x = 0; x < mappedSize[0]; x++ ) {
-				const util::ivector4 coords( x, y, mappedCoords[2] );
-				static_cast<data::Chunk &>( sliceChunk ).voxel<TYPE>( coords[0], coords[1] ) = chunk.voxel<TYPE>( coords[mapping[0]], coords[mapping[1]], coords[mapping[2]] );
+		if( sliceStrides[0] == 1 ) {
+			copyRows( dest, destWidth, src, sliceStrides[1], width, height, convert, parallel );
+		} else {
+			copyTiled( dest, destWidth, src, sliceStrides[0], sliceStrides[1], width, height, convert, parallel );
+		}
+
+		clearBorder<DEST>( dest, destWidth, destHeight, width, height );
+	}
+
+	///slice rows are contiguous in the volume -> simply copy them row by row
+	template<typename SRC, typename DEST, typename CONVERT>
+	static void copyRows( DEST *dest, const size_t &destWidth, const SRC *src, const size_t &srcStrideY, const int32_t &width, const int32_t &height, const CONVERT &convert, bool parallel ) {
+		#pragma omp parallel for if( parallel )
+
+		for( int32_t y = 0; y < height; y++ ) {
+			const SRC *srcRow = src + y * srcStrideY;
+			std::transform( srcRow, srcRow + width, dest + y * destWidth, convert );
+		}
+	}
+
+	///slice rows are not contiguous in the volume -> copy tile by tile so source and destination lines stay in cache
+	template<typename SRC, typename DEST, typename CONVERT>
+	static void copyTiled( DEST *dest, const size_t &destWidth, const SRC *src, const size_t &srcStrideX, const size_t &srcStrideY, const int32_t &width, const int32_t &height, const CONVERT &convert, bool parallel ) {
+		#pragma omp parallel for if( parallel )
+
+		for( int32_t tileY = 0; tileY < height; tileY += m_TileSize ) {
+			const int32_t endY = std::min( tileY + m_TileSize, height );
+
+			for( int32_t tileX = 0; tileX < width; tileX += m_TileSize ) {
+				const int32_t endX = std::min( tileX + m_TileSize, width );
+
+				if( srcStrideY == 1 ) {
+					//walk along the contiguous source axis in the innermost loop
+					for( int32_t x = tileX; x < endX; x++ ) {
+						const SRC *srcColumn = src + x * srcStrideX;
+
+						for( int32_t y = tileY; y < endY; y++ ) {
+							dest[y * destWidth + x] = convert( srcColumn[y] );
+						}
+					}
+				} else {
+					for( int32_t y = tileY; y < endY; y++ ) {
+						const SRC *srcRow = src + y * srcStrideY;
+						DEST *destRow = dest + y * destWidth;
+
+						for( int32_t x = tileX; x < endX; x++ ) {
+							destRow[x] = convert( srcRow[x * srcStrideX] );
+						}
+					}
+				}
 			}
 		}
 	}
 
-private:
-	QViewerCore *m_ViewerCore;
+	///sets the padding of dest that is not covered by the slice to 0
+	template<typename TYPE>
+	static void clearBorder( TYPE *dest, const size_t &destWidth, const size_t &destHeight, const int32_t &width, const int32_t &height ) {
+		if( static_cast<size_t>( width ) < destWidth ) {
+			for( int32_t y = 0; y < height; y++ ) {
+				std::fill( dest + y * destWidth + width, dest + ( y + 1 ) * destWidth, TYPE() );
+			}
+		}
+
+		std::fill( dest + height * destWidth, dest + destHeight * destWidth, TYPE() );
+	}
 };
 
 
 
+
 }
 } // end namespace
 
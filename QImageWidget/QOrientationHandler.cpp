@@ -34,68 +34,18 @@ namespace viewer
 {
 
 
-util::fvector4 QOrientationHandler::mapCoordsToOrientation( const util::fvector4 &coords, const boost::shared_ptr< ImageHolder > image, PlaneOrientation orientation, bool back, bool absolute )
+util::fvector4 QOrientationHandler::mapCoordsToOrientation( const util::fvector4 &coords, const boost::shared_ptr< ImageHolder > &image, PlaneOrientation orientation, bool back, bool absolute )
 {
-	using namespace boost::numeric::ublas;
-	matrix<float> transformMatrix = identity_matrix<float>( 4, 4 );
-	matrix<float> finMatrix = identity_matrix<float>( 4, 4 );
-	vector<float> vec = vector<float>( 4 );
-	vector<float> finVec = vector<float>( 4 );
-
-	for( size_t i = 0; i < 4 ; i++ ) {
-		vec( i ) = coords[i];
-	}
-
-	switch ( orientation ) {
-	case axial:
-		/*setup axial matrix
-		*-1  0  0
-		* 0 -1  0
-		* 0  0  1
-		*/
-		transformMatrix( 0, 0 ) = -1;
-		transformMatrix( 1, 1 ) = 1;
-		break;
-	case sagittal:
-		/*setup sagittal matrix
-		* 0  1  0
-		* 0  0  1
-		* 1  0  0
-		*/
-		transformMatrix( 0, 0 ) = 0;
-		transformMatrix( 2, 0 ) = 1;
-		transformMatrix( 0, 1 ) = 1;
-		transformMatrix( 2, 2 ) = 0;
-		transformMatrix( 1, 2 ) = -1;
-		transformMatrix( 1, 1 ) = 0;
-		break;
-	case coronal:
-		/*setup coronal matrix
-		* -1  0  0
-		*  0  0  1
-		*  0  1  0
-		*/
-
-		transformMatrix( 0, 0 ) = -1;
-		transformMatrix( 1, 1 ) = 0;
-		transformMatrix( 2, 2 ) = 0;
-		transformMatrix( 2, 1 ) = 1;
-		transformMatrix( 1, 2 ) = -1;
-		break;
-	}
+	//the product of the plane matrix and latchedOrientation is compiled into a signed permutation by ImageHolder::updateOrientation
+	const OrientationMapping &mapping = image->getOrientationMapping( orientation, back );
+	util::fvector4 retVec;
 
-	if( back ) {
-		finVec = prod( trans( prod(  transformMatrix, image->latchedOrientation ) ), vec );
-	} else {
-		finVec = prod( prod( transformMatrix, image->latchedOrientation ) , vec );
-	}
-
-	if( absolute ) {
-		return util::fvector4( fabs( finVec( 0 ) ), fabs( finVec( 1 ) ), fabs( finVec( 2 ) ) , fabs( finVec( 3 ) ) );
-	} else {
-		return util::fvector4( finVec( 0 ), finVec( 1 ), finVec( 2 ), finVec( 3 ) );
+	for( unsigned short i = 0; i < 4; i++ ) {
+		const float value = mapping.sign[i] * coords[mapping.axis[i]];
+		retVec[i] = absolute ? fabs( value ) : value;
 	}
 
+	return retVec;
 }
 
 
@@ -149,8 +99,6 @@ util::ivector4 QOrientationHandler::convertWindow2VoxelCoords( const ViewPortTyp
 	const size_t voxCoordY = ( y - viewPort[3] ) / viewPort[1];
 	util::ivector4 coords =  util::ivector4( voxCoordX, voxCoordY, slice );
 
-	#pragma omp parallel for
-
 	for ( short i = 0; i < 2; i++ ) {
 		coords[i] = mappedSize[i] < 0 ? abs( mappedSize[i] ) - coords[i] - 1 : coords[i];
 		coords[i] = coords[i] < 0 ? 0 : coords[i];
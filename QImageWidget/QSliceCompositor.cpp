@@ -0,0 +1,92 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * QSliceCompositor.cpp
+ *
+ * Description: Blends the slices of several images into one premultiplied ARGB32 image
+ *
+ ******************************************************************/
+#include "QSliceCompositor.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace isis
+{
+namespace viewer
+{
+
+void QSliceCompositor::begin( const int &width, const int &height )
+{
+	if( m_Image.width() != width || m_Image.height() != height ) {
+		m_Image = QImage( width, height, QImage::Format_ARGB32_Premultiplied );
+	}
+
+	m_Image.fill( 0 );
+}
+
+void QSliceCompositor::addSlice( const QImage &slice, const QVector<QRgb> &colorMap, const float &opacity )
+{
+	const uint32_t alpha = static_cast<uint32_t>( std::floor( opacity * 255 + 0.5 ) );
+	const int width = std::min( slice.width(), m_Image.width() );
+	const int height = std::min( slice.height(), m_Image.height() );
+
+	if( !alpha ) {
+		return;
+	}
+
+	//fetch the buffers once outside the parallel loops, scanLine() would check for detaching every time
+	const uint8_t *srcBits = slice.bits();
+	uint8_t *destBits = m_Image.bits();
+	const int srcBytesPerLine = slice.bytesPerLine();
+	const int destBytesPerLine = m_Image.bytesPerLine();
+
+	if( slice.format() == QImage::Format_Indexed8 ) {
+		//resolve colormap and opacity once for all 256 values
+		for( int i = 0; i < 256; i++ ) {
+			const QRgb color = i < colorMap.size() ? colorMap[i] : 0;
+			m_LUT[i] = premultiply( qRed( color ), qGreen( color ), qBlue( color ), ( qAlpha( color ) * alpha + 127 ) / 255 );
+		}
+
+		#pragma omp parallel for
+
+		for( int y = 0; y < height; y++ ) {
+			const uint8_t *src = srcBits + y * srcBytesPerLine;
+			uint32_t *dest = reinterpret_cast<uint32_t *>( destBits + y * destBytesPerLine );
+
+			for( int x = 0; x < width; x++ ) {
+				dest[x] = blend( m_LUT[src[x]], dest[x] );
+			}
+		}
+	} else if ( slice.format() == QImage::Format_RGB888 ) {
+		#pragma omp parallel for
+
+		for( int y = 0; y < height; y++ ) {
+			const uint8_t *src = srcBits + y * srcBytesPerLine;
+			uint32_t *dest = reinterpret_cast<uint32_t *>( destBits + y * destBytesPerLine );
+
+			for( int x = 0; x < width; x++ ) {
+				dest[x] = blend( premultiply( src[3 * x], src[3 * x + 1], src[3 * x + 2], alpha ), dest[x] );
+			}
+		}
+	}
+}
+
+}
+} // end namespace
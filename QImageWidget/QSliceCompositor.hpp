@@ -0,0 +1,85 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * QSliceCompositor.hpp
+ *
+ * Description: Blends the slices of several images into one premultiplied ARGB32 image
+ *
+ ******************************************************************/
+#ifndef QSLICECOMPOSITOR_HPP
+#define QSLICECOMPOSITOR_HPP
+
+#include <QImage>
+#include <QVector>
+#include <QRgb>
+#include <stdint.h>
+
+namespace isis
+{
+namespace viewer
+{
+
+/**
+ * Resolves the colormap lookup and the opacity of every slice and blends it into one
+ * premultiplied ARGB32 image, so the painter only has to draw (and scale) one image.
+ * All slices added between begin() and getImage() have to be of the same size.
+ */
+class QSliceCompositor
+{
+public:
+	///resizes the composed image if necessary and makes it fully transparent
+	void begin( const int &width, const int &height );
+
+	/**
+	 * Blends the slice on top of the composed image.
+	 * \param slice the slice either of format QImage::Format_Indexed8 or QImage::Format_RGB888
+	 * \param colorMap the colormap of the slice. Only used for indexed slices.
+	 * \param opacity the opacity of the slice
+	 */
+	void addSlice( const QImage &slice, const QVector<QRgb> &colorMap, const float &opacity );
+
+	const QImage &getImage() const { return m_Image; }
+
+private:
+	QImage m_Image;
+	uint32_t m_LUT[256];
+
+	///premultiplied "source over destination" for two premultiplied ARGB32 pixels. Handles two channels at once.
+	static inline uint32_t blend( const uint32_t &src, const uint32_t &dest ) {
+		const uint32_t invAlpha = 255 - ( src >> 24 );
+		uint32_t rb = ( dest & 0xff00ff ) * invAlpha;
+		rb = ( ( rb + ( ( rb >> 8 ) & 0xff00ff ) + 0x800080 ) >> 8 ) & 0xff00ff;
+		uint32_t ag = ( ( dest >> 8 ) & 0xff00ff ) * invAlpha;
+		ag = ( ag + ( ( ag >> 8 ) & 0xff00ff ) + 0x800080 ) & 0xff00ff00;
+		return src + ( ag | rb );
+	}
+
+	static inline uint32_t premultiply( const uint8_t &red, const uint8_t &green, const uint8_t &blue, const uint32_t &alpha ) {
+		return ( alpha << 24 )
+			   | ( ( ( red * alpha + 127 ) / 255 ) << 16 )
+			   | ( ( ( green * alpha + 127 ) / 255 ) << 8 )
+			   | ( ( blue * alpha + 127 ) / 255 );
+	}
+};
+
+}
+} // end namespace
+
+#endif
@@ -45,6 +45,20 @@
 #include "internal/error.hpp"
 #include <mainwindow.hpp>
 
+///vista files are read with the "onlyfirst" dialect if visualizeOnlyFirstVista is set and no dialect was specified
+std::string getReadDialect( isis::viewer::QViewerCore *core, isis::qt4::IOQtApplication &app, const std::string &fileName )
+{
+	std::string dialect = app.parameters["rdialect"].toString();
+
+	if( boost::filesystem::extension( boost::filesystem::path( fileName ) ) == std::string( ".v" ) && core->getOptionMap()->getPropertyAs<bool>( "visualizeOnlyFirstVista" ) ) {
+		if( !dialect.size() ) {
+			dialect = std::string( "onlyfirst" );
+		}
+	}
+
+	return dialect;
+}
+
 int main( int argc, char *argv[] )
 {
 
@@ -116,47 +130,26 @@ int main( int argc, char *argv[] )
 
 	util::slist fileList = app.parameters["in"];
 	const util::slist zmapFileList = app.parameters["zmap"];
-	std::list< data::Image > imgList;
-	std::list< data::Image > zImgList;
-        
+	ImageHolder::ImageListType imgList;
+	ImageHolder::ImageListType zImgList;
+
 	if( fileList.size() || zmapFileList.size() ) {
-		//load the anatomical images
+		//the anatomical images and the zmap images are loaded concurrently
+		std::list< _internal::FileInformation > fileInfoList;
 		BOOST_FOREACH ( util::slist::const_reference fileName, fileList ) {
-			std::string dialect = app.parameters["rdialect"].toString();
-			std::stringstream fileLoad;
-			fileLoad << "Loading \"" << boost::filesystem::path( fileName ).leaf() << "\" ...";
-			core->getUICore()->getMainWindow()->toggleLoadingIcon( true, fileLoad.str().c_str() );
-
-           if( boost::filesystem::extension( boost::filesystem::path( fileName ) ) == std::string( ".v" ) && core->getOptionMap()->getPropertyAs<bool>("visualizeOnlyFirstVista") ) {
-				if( !dialect.size() ) {
-					dialect = std::string( "onlyfirst" );
-				}
-			}
-			
-			std::list< data::Image > tmpList = data::IOFactory::load( fileName, app.parameters["rf"].toString(), dialect );
-			BOOST_FOREACH( std::list< data::Image >::reference imageRef, tmpList ) {
-				imgList.push_back( imageRef );
-
-			}
+			fileInfoList.push_back( _internal::FileInformation( fileName, getReadDialect( core, app, fileName ), app.parameters["rf"].toString(), ImageHolder::structural_image ) );
 		}
-		//load the zmap images
 		BOOST_FOREACH ( util::slist::const_reference fileName, zmapFileList ) {
-			std::string dialect = app.parameters["rdialect"].toString();
-			std::stringstream fileLoad;
-			fileLoad << "Loading \"" << boost::filesystem::path( fileName ).leaf() << "\" ...";
-			core->getUICore()->getMainWindow()->toggleLoadingIcon(true, fileLoad.str().c_str() );
-
-           if( boost::filesystem::extension( boost::filesystem::path( fileName ) ) == std::string( ".v" ) && core->getOptionMap()->getPropertyAs<bool>("visualizeOnlyFirstVista") ) {
-				if( !dialect.size() ) {
-					dialect = std::string( "onlyfirst" );
-				}
-			}
-			
-			std::list< data::Image > tmpList = data::IOFactory::load( fileName, app.parameters["rf"].toString(), dialect );
-			BOOST_FOREACH( std::list< data::Image >::reference imageRef, tmpList ) {
-				zImgList.push_back( imageRef );
-
-			}
+			fileInfoList.push_back( _internal::FileInformation( fileName, getReadDialect( core, app, fileName ), app.parameters["rf"].toString(), ImageHolder::z_map ) );
+		}
+		std::stringstream fileLoad;
+		fileLoad << "Loading " << fileInfoList.size() << " file(s) ...";
+		core->getUICore()->getMainWindow()->toggleLoadingIcon( true, fileLoad.str().c_str() );
+		const std::vector<ImageHolder::ImageListType> loadedImages = core->loadFiles( fileInfoList );
+
+		for( size_t i = 0; i < loadedImages.size(); i++ ) {
+			ImageHolder::ImageListType &destList = i < fileList.size() ? imgList : zImgList;
+			destList.insert( destList.end(), loadedImages[i].begin(), loadedImages[i].end() );
 		}
 	} else if( core->getOptionMap()->getPropertyAs<bool>( "showStartWidget" ) ) {
 		core->getUICore()->getMainWindow()->startWidget->show();
@@ -177,7 +170,9 @@ int main( int argc, char *argv[] )
 	//particular distribution of images in widgets
 	if( app.parameters["zmap"].isSet() && zImgList.size() > 1 ) {
 		core->getUICore()->setViewWidgetArrangement( UICore::InRow );
-		BOOST_FOREACH( ImageListRef image, core->addImageList( zImgList, ImageHolder::z_map ) ) {
+		bool anatomicalImagesAdded = false;
+		BOOST_FOREACH( ImageListRef image, zImgList ) {
+			core->addImageHolder( image );
 			checkForCaCp( image );
 			core->getRecentFiles().insertSave( _internal::FileInformation( image->getFileNames().front(),
 																			app.parameters["rdialect"].toString(),
@@ -185,25 +180,28 @@ int main( int argc, char *argv[] )
 																			image->imageType) );
 			UICore::ViewWidgetEnsembleType ensemble = core->getUICore()->createViewWidgetEnsemble( "", image );
 
-			if( app.parameters["in"].isSet() ) {
-				BOOST_FOREACH( std::list<data::Image>::const_reference image, imgList ) {
-					boost::shared_ptr<ImageHolder> anatomicalImage = core->addImage( image, ImageHolder::structural_image );
+			//every zmap gets the anatomical images, they are shared by all widgets
+			BOOST_FOREACH( ImageListRef anatomicalImage, imgList ) {
+				if( !anatomicalImagesAdded ) {
+					core->addImageHolder( anatomicalImage );
 					checkForCaCp( anatomicalImage );
+				}
 
-					if( anatomicalImage->getImageSize()[3] == 1 ) {
-						ensemble[0].widgetImplementation->addImage( anatomicalImage );
-						ensemble[1].widgetImplementation->addImage( anatomicalImage );
-						ensemble[2].widgetImplementation->addImage( anatomicalImage );
-					}
+				if( anatomicalImage->getImageSize()[3] == 1 ) {
+					ensemble[0].widgetImplementation->addImage( anatomicalImage );
+					ensemble[1].widgetImplementation->addImage( anatomicalImage );
+					ensemble[2].widgetImplementation->addImage( anatomicalImage );
 				}
 			}
+			anatomicalImagesAdded = true;
 		}
 		core->getUICore()->setOptionPosition( isis::viewer::UICore::bottom );
 		core->getUICore()->getMainWindow()->startWidget->close();
 		//only anatomical images with split option was specified
 	} else if ( app.parameters["in"].isSet() && app.parameters["split"].isSet() ) {
 		core->getUICore()->setViewWidgetArrangement( UICore::InRow );
-		BOOST_FOREACH( ImageListRef image, core->addImageList( imgList, ImageHolder::structural_image ) ) {
+		BOOST_FOREACH( ImageListRef image, imgList ) {
+			core->addImageHolder( image );
 			checkForCaCp( image );
 			core->getRecentFiles().insertSave( _internal::FileInformation( image->getFileNames().front(),
 																			app.parameters["rdialect"].toString(),
@@ -216,7 +214,8 @@ int main( int argc, char *argv[] )
 	} else if ( app.parameters["in"].isSet() || app.parameters["zmap"].isSet() ) {
 		core->getUICore()->setViewWidgetArrangement( UICore::InRow );
 		UICore::ViewWidgetEnsembleType ensemble = core->getUICore()->createViewWidgetEnsemble( "" );
-		BOOST_FOREACH( ImageListRef image, core->addImageList( imgList, ImageHolder::structural_image ) ) {
+		BOOST_FOREACH( ImageListRef image, imgList ) {
+			core->addImageHolder( image );
 			checkForCaCp( image );
 			core->getRecentFiles().insertSave( _internal::FileInformation( image->getFileNames().front(),
 																			app.parameters["rdialect"].toString(),
@@ -226,7 +225,8 @@ int main( int argc, char *argv[] )
 			core->attachImageToWidget( image, ensemble[1]. widgetImplementation );
 			core->attachImageToWidget( image, ensemble[2]. widgetImplementation );
 		}
-		BOOST_FOREACH( ImageListRef image, core->addImageList( zImgList, ImageHolder::z_map ) ) {
+		BOOST_FOREACH( ImageListRef image, zImgList ) {
+			core->addImageHolder( image );
 			checkForCaCp( image );
 			core->getRecentFiles().insertSave( _internal::FileInformation( image->getFileNames().front(),
 																			app.parameters["rdialect"].toString(),
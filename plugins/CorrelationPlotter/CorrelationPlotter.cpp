@@ -70,6 +70,8 @@ void isis::viewer::plugin::CorrelationPlotterDialog::closeEvent( QCloseEvent * )
 		calculateCorrelation( true );
 	}
 
+	m_Correlation.reset();
+
 	m_ViewerCore->setMode( m_OrigMode );
 	m_ViewerCore->getUICore()->refreshUI();
 
@@ -158,13 +160,9 @@ bool isis::viewer::plugin::CorrelationPlotterDialog::createCorrelationMap()
 			m_CurrentCorrelationMap->minMax.second = util::Value<MapImageType>( 1 );
 			m_CurrentCorrelationMap->internMinMax.first = util::Value<MapImageType>( 0 );
 			m_CurrentCorrelationMap->internMinMax.second = util::Value<MapImageType>( 255 );
-			m_CurrentCorrelationMap->scalingToInternalType.first = util::Value<MapImageType>(128);
-			m_CurrentCorrelationMap->scalingToInternalType.second = util::Value<MapImageType>(127);
+			//r in [-1,1] is mapped to [0,255], writeRegion and the per voxel updates both use this scaling
+			m_CurrentCorrelationMap->setInternalScaling( 128, 127 );
 			m_CurrentCorrelationMap->extent = m_CurrentCorrelationMap->minMax.second->as<double>() -  m_CurrentCorrelationMap->minMax.first->as<double>();
-			isis::data::ValuePtr<InternalFunctionalImageType> imagePtr( ( InternalFunctionalImageType * )
-					calloc( m_CurrentFunctionalImage->getISISImage()->getVolume(), sizeof( InternalFunctionalImageType ) ), m_CurrentFunctionalImage->getISISImage()->getVolume() );
-			m_CurrentFunctionalImage->getISISImage()->copyToMem<InternalFunctionalImageType>( &imagePtr[0], m_CurrentFunctionalImage->getISISImage()->getVolume() );
-			m_InternalChunk.reset( new isis::data::Chunk( imagePtr, size[0], size[1], size[2], size[3] ) );
 			m_CurrentCorrelationMap->updateColorMap();
 			util::ivector4 voxelCoords = m_CurrentFunctionalImage->voxelCoords;
 			util::fvector4 physicalCoords = m_CurrentFunctionalImage->physicalCoords;
@@ -180,91 +178,62 @@ bool isis::viewer::plugin::CorrelationPlotterDialog::createCorrelationMap()
 }
 
 
+void isis::viewer::plugin::CorrelationPlotterDialog::storeCorrelation( MapImageType *mapData, InternalImageType *internData, const size_t &index, const float &r, const double &scaling, const double &offset ) const
+{
+	mapData[index] = r;
+	const double internValue = r * scaling + offset;
+	internData[index] = static_cast<InternalImageType>( std::max<double>( 0, std::min<double>( internValue, std::numeric_limits<InternalImageType>::max() ) ) );
+}
+
 void isis::viewer::plugin::CorrelationPlotterDialog::calculateCorrelation( bool all )
 {
-	const size_t vol = m_CurrentFunctionalImage->getImageSize()[0] * m_CurrentFunctionalImage->getImageSize()[1] * m_CurrentFunctionalImage->getImageSize()[2];
-	const size_t n = m_CurrentFunctionalImage->getImageSize()[3];
-	double sum_x = 0;
-	double sum_quad_x = 0;
-	InternalFunctionalImageType *vx = &m_InternalChunk->voxel<InternalFunctionalImageType>( m_CurrentVoxelPos[0], m_CurrentVoxelPos[1], m_CurrentVoxelPos[2] );
-
-	for( size_t t = 0; t < n * vol ; t += vol ) {
-		sum_x += vx[t];
-		sum_quad_x += vx[t] * vx[t];
+	if( !m_Correlation ) {
+		m_Correlation.reset( new operation::Correlation( m_CurrentFunctionalImage->getTimeSeries( true ), m_CurrentFunctionalImage->getImageSize() ) );
 	}
 
-	const double _x = sum_x / n;
-
-	const double s_x = std::sqrt( ( 1 / float( n - 1 ) ) * ( sum_quad_x - n * _x * _x ) );
+	const util::FixedVector<size_t, 4> size = m_CurrentFunctionalImage->getImageSize();
+	m_Correlation->setSeed( ( m_CurrentVoxelPos[2] * size[1] + m_CurrentVoxelPos[1] ) * size[0] + m_CurrentVoxelPos[0] );
+	//the map is a single chunk, so its voxels and those of the internal volume are laid out the same way
+	data::Chunk mapChunk = m_CurrentCorrelationMap->getISISImage()->getChunk( 0, 0, 0, 0, false );
+	data::Chunk internVolume = m_CurrentCorrelationMap->getVolume( 0 );
+	MapImageType *mapData = &mapChunk.voxel<MapImageType>( 0, 0, 0 );
+	InternalImageType *internData = &internVolume.voxel<InternalImageType>( 0, 0, 0 );
 
 	if( !all ) {
+		const double scaling = m_CurrentCorrelationMap->scalingToInternalType.first->as<double>();
+		const double offset = m_CurrentCorrelationMap->scalingToInternalType.second->as<double>();
 		#pragma omp parallel for
 
-		for( unsigned int z = 0; z < m_CurrentFunctionalImage->getImageSize()[2]; z++ ) {
-			for( unsigned int y = 0; y < m_CurrentFunctionalImage->getImageSize()[1]; y++ ) {
-				_internCalculateCorrelation( util::ivector4( m_CurrentVoxelPos[0], y, z ), s_x, _x, vx, n, vol );
+		for( int32_t z = 0; z < static_cast<int32_t>( size[2] ); z++ ) {
+			for( size_t y = 0; y < size[1]; y++ ) {
+				const size_t index = ( z * size[1] + y ) * size[0] + m_CurrentVoxelPos[0];
+				storeCorrelation( mapData, internData, index, m_Correlation->correlate( index ), scaling, offset );
 			}
 		}
 
 		#pragma omp parallel for
 
-		for( unsigned int y = 0; y < m_CurrentFunctionalImage->getImageSize()[1]; y++ ) {
-			for( unsigned int x = 0; x < m_CurrentFunctionalImage->getImageSize()[0]; x++ ) {
-				_internCalculateCorrelation( util::ivector4( x, y, m_CurrentVoxelPos[2] ), s_x, _x, vx, n, vol );
+		for( int32_t y = 0; y < static_cast<int32_t>( size[1] ); y++ ) {
+			for( size_t x = 0; x < size[0]; x++ ) {
+				const size_t index = ( m_CurrentVoxelPos[2] * size[1] + y ) * size[0] + x;
+				storeCorrelation( mapData, internData, index, m_Correlation->correlate( index ), scaling, offset );
 			}
 		}
 
 		#pragma omp parallel for
 
-		for( unsigned int z = 0; z < m_CurrentFunctionalImage->getImageSize()[2]; z++ ) {
-			for( unsigned int x = 0; x < m_CurrentFunctionalImage->getImageSize()[0]; x++ ) {
-				_internCalculateCorrelation( util::ivector4( x, m_CurrentVoxelPos[1], z ), s_x, _x, vx, n, vol );
+		for( int32_t z = 0; z < static_cast<int32_t>( size[2] ); z++ ) {
+			for( size_t x = 0; x < size[0]; x++ ) {
+				const size_t index = ( z * size[1] + m_CurrentVoxelPos[1] ) * size[0] + x;
+				storeCorrelation( mapData, internData, index, m_Correlation->correlate( index ), scaling, offset );
 			}
 		}
 	} else {
-		
-
-		for( unsigned int z = 0; z < m_CurrentFunctionalImage->getImageSize()[2]; z++ ) {
-			for( unsigned int y = 0; y < m_CurrentFunctionalImage->getImageSize()[1]; y++ ) {
-				#pragma omp parallel for
-				for( unsigned int x = 0; x < m_CurrentFunctionalImage->getImageSize()[0]; x++ ) {
-					_internCalculateCorrelation( util::ivector4( x, y, z ), s_x, _x, vx, n, vol );
-				}
-			}
-		}
-		m_CurrentCorrelationMap->updateHistogram();;
+		m_Correlation->computeMap( mapData );
+		//the map already holds the values, so only the internal volume is written
+		m_CurrentCorrelationMap->writeVolume( mapData, 0, false );
 	}
-	
 
-}
-
-void isis::viewer::plugin::CorrelationPlotterDialog::_internCalculateCorrelation( const isis::util::ivector4 &vec, const double &s_x, const double &_x, const InternalFunctionalImageType *vx, const size_t &n, const size_t &vol )
-{
-	double sum_quad_y = 0;
-	double sum_y = 0;
-	double sum_xy = 0;
-	InternalFunctionalImageType *vy = &m_InternalChunk->voxel<InternalFunctionalImageType>( vec[0], vec[1], vec[2] );
-
-	for ( size_t t = 0; t < n * vol; t += vol ) {
-		sum_quad_y += vy[t] * vy[t];
-		sum_y += vy[t];
-		sum_xy += vx[t] * vy[t];
-	}
-
-	const double _y = sum_y / n;
-
-	const double s_xy = ( 1 / float( n - 1 ) ) * ( sum_xy - n * _x * _y );
-
-	const double s_y = std::sqrt( ( 1 / float( n - 1 ) ) * ( sum_quad_y - n * _y * _y ) );
-
-	double r_xy = s_xy / ( s_x * s_y );
-	
-	if( !std::isnan( r_xy ) ) {
-		m_CurrentCorrelationMap->setTypedVoxel<MapImageType>(vec[0], vec[1], vec[2], 0, r_xy );
-	} else {
-		m_CurrentCorrelationMap->setTypedVoxel<MapImageType>(vec[0], vec[1], vec[2], 0, 0 );
-	}
+	m_CurrentCorrelationMap->voxelDataChanged();
 
 }
-
-
@@ -31,6 +31,7 @@
 #include "ui_correlationPlotter.h"
 #include <QWidget>
 #include "qviewercore.hpp"
+#include "correlation.hpp"
 #include <cmath>
 
 namespace isis
@@ -44,7 +45,6 @@ class CorrelationPlotterDialog : public QDialog
 {
 	Q_OBJECT
 	typedef double MapImageType;
-	typedef uint16_t InternalFunctionalImageType;
 public:
 	CorrelationPlotterDialog( QWidget *parent, QViewerCore *core );
 
@@ -62,12 +62,12 @@ private:
 	QViewerCore *m_ViewerCore;
 	boost::shared_ptr<ImageHolder> m_CurrentCorrelationMap;
 	boost::shared_ptr<ImageHolder> m_CurrentFunctionalImage;
-	boost::scoped_ptr< isis::data::Chunk > m_InternalChunk;
 	util::ivector4 m_CurrentVoxelPos;
 
+	///works on the time-contiguous copy of the functional image, see ImageHolder::getTimeSeries
+	boost::scoped_ptr<operation::Correlation> m_Correlation;
 
-	void _internCalculateCorrelation( const util::ivector4 &vec, const double &s_x, const double &_x, const InternalFunctionalImageType *vx, const size_t &n, const size_t &vol  );
-
+	void storeCorrelation( MapImageType *mapData, InternalImageType *internData, const size_t &index, const float &r, const double &scaling, const double &offset ) const;
 };
 
 
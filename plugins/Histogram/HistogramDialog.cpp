@@ -65,11 +65,9 @@ void isis::viewer::plugin::HistogramDialog::paintHistogram()
 		double xData[255];
 		BOOST_FOREACH( DataContainer::const_reference image, m_ViewerCore->getDataContainer() ) {
 			if( !image.second->isRGB ) {
-				const double scaling = image.second->scalingToInternalType.first->as<double>();
-				const double offset = image.second->scalingToInternalType.second->as<double>();
-
+				//the histogram is plotted without the bin of value 0
 				for( unsigned short i = 0; i < 255; i++ ) {
-					xData[i] = ( double )( i - offset ) / scaling ;
+					xData[i] = image.second->getHistogramBinValue( i + 1 );
 				}
 
 				QwtPlotCurve *curve = new QwtPlotCurve();
@@ -89,7 +87,7 @@ void isis::viewer::plugin::HistogramDialog::paintHistogram()
 				}
 
 				const uint16_t timestep = image.second->getImageSize()[3] > 1 ? image.second->voxelCoords[3] : 0;
-				curve->setData( xData, image.second->histogramVectorWOZero[timestep], 255 );
+				curve->setData( xData, image.second->getHistogram( timestep, true ), 255 );
 			}
 		}
 		m_Zoomer->setZoomBase(true);
@@ -0,0 +1,216 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * Brush.cpp
+ *
+ * Description: sphere brush for painting masks with undo and redo
+ *
+ ******************************************************************/
+#include "Brush.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace isis
+{
+namespace viewer
+{
+namespace plugin
+{
+
+const size_t Brush::maxUndoSteps;
+
+Brush::Brush()
+	: m_StrokeOpen( false )
+{}
+
+const Brush::SphereType &Brush::getSphere( const unsigned short &radius )
+{
+	std::map<unsigned short, SphereType>::const_iterator iter = m_Spheres.find( radius );
+
+	if( iter != m_Spheres.end() ) {
+		return iter->second;
+	}
+
+	SphereType &sphere = m_Spheres[radius];
+	//offsets up to radius - 1 in every direction, cut to a ball of the radius
+	const int32_t extent = radius - 1;
+
+	for( int32_t z = -extent; z <= extent; z++ ) {
+		for( int32_t y = -extent; y <= extent; y++ ) {
+			const int32_t rest = radius * radius - y * y - z * z;
+
+			if( rest < 0 ) {
+				continue;
+			}
+
+			const int32_t halfWidth = std::min<int32_t>( extent, static_cast<int32_t>( std::sqrt( static_cast<double>( rest ) ) ) );
+			const Span span = { -halfWidth, y, z, 2 * halfWidth + 1 };
+			sphere.push_back( span );
+		}
+	}
+
+	return sphere;
+}
+
+Brush::Stroke &Brush::getStroke( boost::shared_ptr<ImageHolder> image )
+{
+	if( image != m_Image.lock() ) {
+		clear();
+		m_Image = image;
+	}
+
+	if( !m_StrokeOpen || m_UndoStack.empty() ) {
+		Stroke stroke;
+		stroke.start = util::ivector4( std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max() );
+		stroke.end = util::ivector4( -1, -1, -1, -1 );
+		m_UndoStack.push_back( stroke );
+		m_RedoStack.clear();
+		m_StrokeOpen = true;
+
+		if( m_UndoStack.size() > maxUndoSteps ) {
+			m_UndoStack.pop_front();
+		}
+	}
+
+	return m_UndoStack.back();
+}
+
+void Brush::clear()
+{
+	m_UndoStack.clear();
+	m_RedoStack.clear();
+	m_StrokeOpen = false;
+	m_Image.reset();
+}
+
+template<typename INTERNAL>
+void Brush::fillRun( ImageHolder &image, size_t start, size_t length, const double &value )
+{
+	const util::FixedVector<size_t, 4> size = image.getImageSize();
+	const INTERNAL internalValue = image.convertToInternal<double, INTERNAL>( value );
+
+	//a run can continue in the next row
+	while( length ) {
+		const size_t x = start % size[0];
+		const size_t y = ( start / size[0] ) % size[1];
+		const size_t z = ( start / ( size[0] * size[1] ) ) % size[2];
+		const size_t t = start / ( size[0] * size[1] * size[2] );
+		const size_t count = std::min( length, size[0] - x );
+		data::Chunk chunk = image.getISISImage()->getChunk( x, y, z, t, false );
+		const util::FixedVector<size_t, 4> chunkSize = chunk.getSizeAsVector();
+
+		switch( chunk.getTypeID() ) {
+		case data::ValuePtr<bool>::staticID:
+			std::fill_n( &chunk.voxel<bool>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<bool>( value ) );
+			break;
+		case data::ValuePtr<int8_t>::staticID:
+			std::fill_n( &chunk.voxel<int8_t>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<int8_t>( value ) );
+			break;
+		case data::ValuePtr<uint8_t>::staticID:
+			std::fill_n( &chunk.voxel<uint8_t>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<uint8_t>( value ) );
+			break;
+		case data::ValuePtr<int16_t>::staticID:
+			std::fill_n( &chunk.voxel<int16_t>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<int16_t>( value ) );
+			break;
+		case data::ValuePtr<uint16_t>::staticID:
+			std::fill_n( &chunk.voxel<uint16_t>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<uint16_t>( value ) );
+			break;
+		case data::ValuePtr<int32_t>::staticID:
+			std::fill_n( &chunk.voxel<int32_t>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<int32_t>( value ) );
+			break;
+		case data::ValuePtr<uint32_t>::staticID:
+			std::fill_n( &chunk.voxel<uint32_t>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<uint32_t>( value ) );
+			break;
+		case data::ValuePtr<int64_t>::staticID:
+			std::fill_n( &chunk.voxel<int64_t>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<int64_t>( value ) );
+			break;
+		case data::ValuePtr<uint64_t>::staticID:
+			std::fill_n( &chunk.voxel<uint64_t>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<uint64_t>( value ) );
+			break;
+		case data::ValuePtr<float>::staticID:
+			std::fill_n( &chunk.voxel<float>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<float>( value ) );
+			break;
+		case data::ValuePtr<double>::staticID:
+			std::fill_n( &chunk.voxel<double>( x % chunkSize[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), count, static_cast<double>( value ) );
+			break;
+		default:
+			LOG( Runtime, error ) << "Can not write voxels to a chunk of type " << chunk.getTypeName() << "!";
+			break;
+		}
+
+		data::Chunk volume = image.getVolume( t );
+		std::fill_n( &volume.voxel<INTERNAL>( x, y, z ), count, internalValue );
+		start += count;
+		length -= count;
+	}
+}
+
+void Brush::fillRun( ImageHolder &image, const Run &run, bool undo )
+{
+	if( image.isHighPrecision() ) {
+		fillRun<InternalImageHighPrecisionType>( image, run.start, run.length, undo ? run.before : run.after );
+	} else {
+		fillRun<InternalImageType>( image, run.start, run.length, undo ? run.before : run.after );
+	}
+}
+
+bool Brush::undo( boost::shared_ptr<ImageHolder> image )
+{
+	endStroke();
+
+	if( image != m_Image.lock() || m_UndoStack.empty() ) {
+		return false;
+	}
+
+	const Stroke &stroke = m_UndoStack.back();
+
+	//the runs of overlapping spheres are reverted in reverse order, so every voxel gets the value it had before the stroke
+	for( std::vector<Run>::const_reverse_iterator iter = stroke.runs.rbegin(); iter != stroke.runs.rend(); iter++ ) {
+		fillRun( *image, *iter, true );
+	}
+
+	image->voxelDataChanged( stroke.start, stroke.end );
+	m_RedoStack.push_back( stroke );
+	m_UndoStack.pop_back();
+	return true;
+}
+
+bool Brush::redo( boost::shared_ptr<ImageHolder> image )
+{
+	endStroke();
+
+	if( image != m_Image.lock() || m_RedoStack.empty() ) {
+		return false;
+	}
+
+	const Stroke &stroke = m_RedoStack.back();
+	BOOST_FOREACH( std::vector<Run>::const_reference run, stroke.runs ) {
+		fillRun( *image, run, false );
+	}
+	image->voxelDataChanged( stroke.start, stroke.end );
+	m_UndoStack.push_back( stroke );
+	m_RedoStack.pop_back();
+	return true;
+}
+
+}
+}
+}
@@ -0,0 +1,199 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * Brush.hpp
+ *
+ * Description: sphere brush for painting masks with undo and redo
+ *
+ ******************************************************************/
+#ifndef BRUSH_HPP
+#define BRUSH_HPP
+
+#include "imageholder.hpp"
+#include <boost/noncopyable.hpp>
+#include <boost/weak_ptr.hpp>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace isis
+{
+namespace viewer
+{
+namespace plugin
+{
+
+/**
+ * Paints spheres into an image and keeps the changes of every stroke for undo and redo.
+ * The rows of a sphere are computed once per radius. Painting writes the source image and the internal volume
+ * of the current timestep directly, only the voxels that really change are written and recorded.
+ * The changes are recorded as runs of neighbouring voxels with the same old value, so a stroke over an empty mask
+ * needs a few runs per row of the brush.
+ * The brush belongs to one image, passing another image clears the undo history.
+ */
+class Brush : boost::noncopyable
+{
+public:
+	///row of a sphere: length voxels starting at the offset x, y, z from the center
+	struct Span {
+		int32_t x, y, z;
+		int32_t length;
+	};
+	typedef std::vector<Span> SphereType;
+
+	Brush();
+
+	///the rows of a sphere with the given radius in voxels, computed when it is requested for the first time
+	const SphereType &getSphere( const unsigned short &radius );
+
+	/**
+	 * Sets all voxels of the sphere around center to value. center[3] is the timestep that is painted.
+	 * The source image has to be of TYPE, rows of chunks with another type are skipped.
+	 * Only the box around the sphere is marked as changed, so only the slices through it are extracted again.
+	 */
+	template<typename TYPE>
+	void paint( boost::shared_ptr<ImageHolder> image, const util::ivector4 &center, const unsigned short &radius, const TYPE &value ) {
+		if( image->isHighPrecision() ) {
+			paint<TYPE, InternalImageHighPrecisionType>( image, center, radius, value );
+		} else {
+			paint<TYPE, InternalImageType>( image, center, radius, value );
+		}
+	}
+
+	///finishes the current stroke, the next call of paint starts a new one
+	void endStroke() { m_StrokeOpen = false; }
+	///reverts the last stroke. Returns false if there is nothing to undo.
+	bool undo( boost::shared_ptr<ImageHolder> image );
+	///repeats the last reverted stroke. Returns false if there is nothing to redo.
+	bool redo( boost::shared_ptr<ImageHolder> image );
+	bool canUndo() const { return !m_UndoStack.empty(); }
+	bool canRedo() const { return !m_RedoStack.empty(); }
+	void clear();
+
+private:
+	///length voxels starting at the linear index start ( of the 4D image ) that had the same value before and after a stroke
+	struct Run {
+		size_t start;
+		size_t length;
+		double before;
+		double after;
+	};
+	struct Stroke {
+		std::vector<Run> runs;
+		///box around all changed voxels
+		util::ivector4 start;
+		util::ivector4 end;
+	};
+	std::map<unsigned short, SphereType> m_Spheres;
+	std::deque<Stroke> m_UndoStack;
+	std::deque<Stroke> m_RedoStack;
+	bool m_StrokeOpen;
+	boost::weak_ptr<ImageHolder> m_Image;
+	///number of strokes that can be undone
+	static const size_t maxUndoSteps = 64;
+
+	///returns the stroke the next changes are recorded in. Starts a new one if the last one is finished.
+	Stroke &getStroke( boost::shared_ptr<ImageHolder> image );
+	static void record( Stroke &stroke, const size_t &index, const double &before, const double &after ) {
+		if( !stroke.runs.empty() ) {
+			Run &last = stroke.runs.back();
+
+			if( last.start + last.length == index && last.before == before && last.after == after ) {
+				last.length++;
+				return;
+			}
+		}
+
+		const Run run = { index, 1, before, after };
+		stroke.runs.push_back( run );
+	}
+	///writes value to both representations of the voxels of the run
+	template<typename INTERNAL>
+	static void fillRun( ImageHolder &image, size_t start, size_t length, const double &value );
+	static void fillRun( ImageHolder &image, const Run &run, bool undo );
+
+	template<typename TYPE, typename INTERNAL>
+	void paint( boost::shared_ptr<ImageHolder> image, const util::ivector4 &center, const unsigned short &radius, const TYPE &value ) {
+		const util::FixedVector<size_t, 4> size = image->getImageSize();
+		const int32_t t = center[3];
+		data::Chunk volume = image->getVolume( t );
+		const INTERNAL internalValue = image->convertToInternal<TYPE, INTERNAL>( value );
+		Stroke *stroke = 0;
+		util::ivector4 start( size[0], size[1], size[2], t );
+		util::ivector4 end( -1, -1, -1, t );
+		BOOST_FOREACH( SphereType::const_reference span, getSphere( radius ) ) {
+			const int32_t y = center[1] + span.y;
+			const int32_t z = center[2] + span.z;
+			const int32_t first = std::max<int32_t>( 0, center[0] + span.x );
+			const int32_t last = std::min<int32_t>( size[0], center[0] + span.x + span.length );
+
+			if( y < 0 || z < 0 || y >= static_cast<int32_t>( size[1] ) || z >= static_cast<int32_t>( size[2] ) || first >= last ) {
+				continue;
+			}
+
+			//a chunk always holds whole rows
+			data::Chunk chunk = image->getISISImage()->getChunk( 0, y, z, t, false );
+
+			if( chunk.getTypeID() != data::ValuePtr<TYPE>::staticID ) {
+				LOG( Runtime, warning ) << "Can not paint into a chunk of type " << chunk.getTypeName() << "!";
+				continue;
+			}
+
+			const util::FixedVector<size_t, 4> chunkSize = chunk.getSizeAsVector();
+			TYPE *src = &chunk.voxel<TYPE>( 0, y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] );
+			INTERNAL *intern = &volume.voxel<INTERNAL>( 0, y, z );
+			const size_t rowStart = ( ( t * size[2] + z ) * size[1] + y ) * size[0];
+
+			for( int32_t x = first; x < last; x++ ) {
+				if( src[x] != value ) {
+					if( !stroke ) {
+						stroke = &getStroke( image );
+					}
+
+					record( *stroke, rowStart + x, src[x], value );
+					src[x] = value;
+					intern[x] = internalValue;
+				}
+			}
+
+			start[0] = std::min( start[0], first );
+			start[1] = std::min( start[1], y );
+			start[2] = std::min( start[2], z );
+			end[0] = std::max( end[0], last - 1 );
+			end[1] = std::max( end[1], y );
+			end[2] = std::max( end[2], z );
+		}
+
+		if( stroke ) {
+			for( size_t i = 0; i < 4; i++ ) {
+				stroke->start[i] = std::min( stroke->start[i], start[i] );
+				stroke->end[i] = std::max( stroke->end[i], end[i] );
+			}
+
+			image->voxelDataChanged( start, end );
+		}
+	}
+};
+
+}
+}
+}
+
+#endif
@@ -120,6 +120,8 @@ void CreateMaskDialog::createMask()
 		}
 
 		m_MaskEditDialog->m_CurrentMask = maskImage;
+		m_MaskEditDialog->m_Brush.clear();
+		m_MaskEditDialog->updateUndoButtons();
 		m_MaskEditDialog->m_CurrentMask->extent = m_MaskEditDialog->m_CurrentMask->minMax.second->as<double>() -  m_MaskEditDialog->m_CurrentMask->minMax.first->as<double>();
 		m_MaskEditDialog->m_CurrentMask->opacity = 0.5;
 		m_MaskEditDialog->m_CurrentMask->lut = "maskeditLUT";
@@ -58,6 +58,9 @@ MaskEditDialog::MaskEditDialog( QWidget *parent, QViewerCore *core )
 	connect( m_Interface.cut, SIGNAL( clicked( bool ) ), this , SLOT( cutClicked() ) );
 	connect( m_Interface.paint, SIGNAL( clicked( bool ) ), this , SLOT( paintClicked() ) );
 	connect( m_Interface.editCurrentImage, SIGNAL( clicked() ), this, SLOT( editCurrentImage() ) );
+	connect( m_Interface.undo, SIGNAL( clicked() ), this, SLOT( undoClicked() ) );
+	connect( m_Interface.redo, SIGNAL( clicked() ), this, SLOT( redoClicked() ) );
+	updateUndoButtons();
 
 }
 
@@ -92,6 +95,7 @@ void MaskEditDialog::radiusChange( int r )
 void MaskEditDialog::showEvent( QShowEvent * )
 {
 	connect( m_ViewerCore, SIGNAL ( emitPhysicalCoordsChanged( util::fvector4 ) ), this, SLOT( physicalCoordChanged( util::fvector4 ) ) );
+	setWidgetEventFilter( true );
 
 	if( !m_CurrentMask ) {
 		m_Interface.cut->setEnabled( false );
@@ -111,45 +115,50 @@ void MaskEditDialog::physicalCoordChanged( util::fvector4 physCoord )
 {
 	if( m_ViewerCore->hasImage() ) {
 		if( m_CurrentMask ) {
+			util::ivector4 voxel = m_CurrentMask->getISISImage()->getIndexFromPhysicalCoords( physCoord, true );
+			//the brush paints into the timestep that is shown
+			voxel[3] = std::min<int32_t>( std::max<int32_t>( m_CurrentMask->voxelCoords[3], 0 ), m_CurrentMask->getImageSize()[3] - 1 );
+
 			switch( m_CurrentMask->majorTypeID ) {
 			case isis::data::ValuePtr<bool>::staticID:
-				manipulateVoxel<bool>( physCoord, std::numeric_limits<bool>::max(), m_CurrentMask );
+				manipulateVoxel<bool>( voxel, std::numeric_limits<bool>::max() );
 				break;
 			case isis::data::ValuePtr<int8_t>::staticID:
-				manipulateVoxel<int8_t>( physCoord, std::numeric_limits<int8_t>::max(), m_CurrentMask );
+				manipulateVoxel<int8_t>( voxel, std::numeric_limits<int8_t>::max() );
 				break;
 			case isis::data::ValuePtr<uint8_t>::staticID:
-				manipulateVoxel<uint8_t>( physCoord, std::numeric_limits<uint8_t>::max(), m_CurrentMask );
+				manipulateVoxel<uint8_t>( voxel, std::numeric_limits<uint8_t>::max() );
 				break;
 			case isis::data::ValuePtr<int16_t>::staticID:
-				manipulateVoxel<int16_t>( physCoord, std::numeric_limits<int16_t>::max(), m_CurrentMask );
+				manipulateVoxel<int16_t>( voxel, std::numeric_limits<int16_t>::max() );
 				break;
 			case isis::data::ValuePtr<uint16_t>::staticID:
-				manipulateVoxel<uint16_t>( physCoord, std::numeric_limits<uint16_t>::max(), m_CurrentMask );
+				manipulateVoxel<uint16_t>( voxel, std::numeric_limits<uint16_t>::max() );
 				break;
 			case isis::data::ValuePtr<int32_t>::staticID:
-				manipulateVoxel<int32_t>( physCoord, std::numeric_limits<int32_t>::max(), m_CurrentMask );
+				manipulateVoxel<int32_t>( voxel, std::numeric_limits<int32_t>::max() );
 				break;
 			case isis::data::ValuePtr<uint32_t>::staticID:
-				manipulateVoxel<uint32_t>( physCoord, std::numeric_limits<uint32_t>::max(), m_CurrentMask );
+				manipulateVoxel<uint32_t>( voxel, std::numeric_limits<uint32_t>::max() );
 				break;
 			case isis::data::ValuePtr<int64_t>::staticID:
-				manipulateVoxel<int64_t>( physCoord, std::numeric_limits<int64_t>::max(), m_CurrentMask );
+				manipulateVoxel<int64_t>( voxel, std::numeric_limits<int64_t>::max() );
 				break;
 			case isis::data::ValuePtr<uint64_t>::staticID:
-				manipulateVoxel<uint64_t>( physCoord, std::numeric_limits<uint64_t>::max(), m_CurrentMask );
+				manipulateVoxel<uint64_t>( voxel, std::numeric_limits<uint64_t>::max() );
 				break;
 			case isis::data::ValuePtr<double>::staticID:
-				manipulateVoxel<double>( physCoord, std::numeric_limits<double>::max(), m_CurrentMask );
+				manipulateVoxel<double>( voxel, std::numeric_limits<double>::max() );
 				break;
 			case isis::data::ValuePtr<float>::staticID:
-				manipulateVoxel<float>( physCoord, std::numeric_limits<float>::max(), m_CurrentMask );
+				manipulateVoxel<float>( voxel, std::numeric_limits<float>::max() );
 				break;
 			default:
 				LOG( Runtime, error ) << "Unknown type ID " << m_CurrentMask->majorTypeID << " when trying to paint mask";
 				break;
 			}
 
+			updateUndoButtons();
 			m_ViewerCore->updateScene();
 		}
 	}
@@ -160,6 +169,8 @@ void MaskEditDialog::editCurrentImage()
 {
 	if( m_ViewerCore->hasImage() ) {
 		m_CurrentMask = m_ViewerCore->getCurrentImage();
+		m_Brush.clear();
+		updateUndoButtons();
 		m_Interface.cut->setEnabled( true );
 		m_Interface.paint->setEnabled( true );
 		m_Interface.radius->setEnabled( true );
@@ -193,6 +204,8 @@ void MaskEditDialog::createEmptyMask()
 void MaskEditDialog::closeEvent( QCloseEvent * )
 {
 	disconnect( m_ViewerCore, SIGNAL ( emitPhysicalCoordsChanged( util::fvector4 ) ), this, SLOT( physicalCoordChanged( util::fvector4 ) ) );
+	setWidgetEventFilter( false );
+	m_Brush.endStroke();
 	BOOST_FOREACH( UICore::ViewWidgetEnsembleListType::const_reference ensemble, m_ViewerCore->getUICore()->getEnsembleList() ) {
 		for ( unsigned short i = 0; i < 3; i++ ) {
 			ensemble[i].widgetImplementation->setMouseCursorIcon( QIcon() );
@@ -203,6 +216,57 @@ void MaskEditDialog::closeEvent( QCloseEvent * )
 }
 
 
+void MaskEditDialog::undoClicked()
+{
+	if( m_CurrentMask && m_Brush.undo( m_CurrentMask ) ) {
+		m_ViewerCore->updateScene();
+	}
+
+	updateUndoButtons();
+}
+
+void MaskEditDialog::redoClicked()
+{
+	if( m_CurrentMask && m_Brush.redo( m_CurrentMask ) ) {
+		m_ViewerCore->updateScene();
+	}
+
+	updateUndoButtons();
+}
+
+void MaskEditDialog::updateUndoButtons()
+{
+	m_Interface.undo->setEnabled( m_Brush.canUndo() );
+	m_Interface.redo->setEnabled( m_Brush.canRedo() );
+}
+
+bool MaskEditDialog::eventFilter( QObject *object, QEvent *event )
+{
+	//everything painted while the mouse button is held down is undone at once
+	if( event->type() == QEvent::MouseButtonRelease ) {
+		m_Brush.endStroke();
+	}
+
+	return QDialog::eventFilter( object, event );
+}
+
+void MaskEditDialog::setWidgetEventFilter( bool install )
+{
+	BOOST_FOREACH( UICore::ViewWidgetEnsembleListType::const_reference ensemble, m_ViewerCore->getUICore()->getEnsembleList() ) {
+		for ( unsigned short i = 0; i < 3; i++ ) {
+			QWidget *widget = dynamic_cast<QWidget *>( ensemble[i].widgetImplementation );
+
+			if( widget ) {
+				if( install ) {
+					widget->installEventFilter( this );
+				} else {
+					widget->removeEventFilter( this );
+				}
+			}
+		}
+	}
+}
+
+}
 }
 }
-}
\ No newline at end of file
@@ -32,6 +32,7 @@
 #include "qviewercore.hpp"
 #include <DataStorage/chunk.hpp>
 #include <boost/assign/list_of.hpp>
+#include "Brush.hpp"
 
 
 namespace isis
@@ -50,6 +51,7 @@ public:
 	friend class CreateMaskDialog;
 
 	MaskEditDialog( QWidget *parent, QViewerCore *core );
+	virtual bool eventFilter( QObject *object, QEvent *event );
 
 public Q_SLOTS:
 	void physicalCoordChanged( util::fvector4 physCoord );
@@ -58,6 +60,8 @@ public Q_SLOTS:
 	void cutClicked();
 	void createEmptyMask();
 	void editCurrentImage();
+	void undoClicked();
+	void redoClicked();
 	virtual void closeEvent( QCloseEvent * );
 	virtual void showEvent( QShowEvent * );
 
@@ -71,44 +75,17 @@ private:
 
 	UICore::ViewWidgetEnsembleType m_CurrentWidgetEnsemble;
 
-	template<typename TYPE>
-	void manipulateVoxel( const util::fvector4 physCoord, const TYPE &value, boost::shared_ptr<ImageHolder> image ) {
-		const util::ivector4 voxel = image->getISISImage()->getIndexFromPhysicalCoords( physCoord, true );
-		const util::ivector4 imageSize = image->getImageSize();
-		util::ivector4 start;
-		util::ivector4 end;
-		const bool cut = m_Interface.cut->isChecked();
-
-		for( unsigned short i = 0; i < 3; i++ ) {
-			start[i] = ( voxel[i] - m_Radius ) < 0 ? 0 : voxel[i] - m_Radius;
-			end[i] = ( voxel[i] + m_Radius ) > imageSize[i] ? imageSize[i] : voxel[i] + m_Radius;
-		}
-
-		unsigned short radSquare = m_Radius * m_Radius;
-		#pragma omp parallel for
-
-		for( unsigned short k = start[2] + 1; k < end[2]; k++ ) {
-			for( unsigned short j = start[1] + 1; j < end[1]; j++ ) {
-				for( unsigned short i = start[0] + 1; i < end[0]; i++ ) {
-					int x = voxel[0] - i;
-					int y = voxel[1] - j;
-					int z = voxel[2] - k;
-
-					if( x *x + y *y + z *z <= radSquare ) {
-						if ( !cut ) {
-							image->getISISImage()->voxel<TYPE>( i, j, k ) = value;
-							image->getChunkVector()[0].voxel<InternalImageType>( i, j, k ) = value;
-						} else {
-							image->getISISImage()->voxel<TYPE>( i, j, k ) = std::numeric_limits<TYPE>::min();
-							image->getChunkVector()[0].voxel<InternalImageType>( i, j, k ) = std::numeric_limits<InternalImageType>::min();
-						}
-					}
-				}
-			}
-		}
+	Brush m_Brush;
 
+	///paints the brush at voxel, or cuts with it if cut is checked
+	template<typename TYPE>
+	void manipulateVoxel( const util::ivector4 &voxel, const TYPE &value ) {
+		m_Brush.paint<TYPE>( m_CurrentMask, voxel, m_Radius, m_Interface.cut->isChecked() ? TYPE() : value );
 	}
 
+	void updateUndoButtons();
+	///installs ( or removes ) this dialog as event filter of the view widgets, so it knows when a stroke ends
+	void setWidgetEventFilter( bool install );
 
 };
 
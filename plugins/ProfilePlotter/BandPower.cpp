@@ -0,0 +1,135 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * BandPower.cpp
+ *
+ * Description: band power and ALFF maps of functional images
+ *
+ ******************************************************************/
+#include "BandPower.hpp"
+#include "Spectrum.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace isis
+{
+namespace viewer
+{
+namespace plugin
+{
+
+const size_t BandPower::batchSize;
+
+std::pair<size_t, size_t> BandPower::getBins( const size_t &n, const double &repetitionTime, const double &lowFrequency, const double &highFrequency )
+{
+	//bin k has the frequency k / ( n * repetitionTime )
+	const double resolution = n * repetitionTime;
+	const size_t nc = Spectrum::getSpectrumSize( n );
+	const size_t first = std::max<size_t>( 1, static_cast<size_t>( std::ceil( lowFrequency * resolution ) ) );
+	const size_t last = std::min<size_t>( nc, static_cast<size_t>( std::floor( highFrequency * resolution ) ) + 1 );
+	return first < last ? std::make_pair( first, last ) : std::make_pair( first, first );
+}
+
+float BandPower::evaluate( const double *power, const size_t &n, const std::pair<size_t, size_t> &bins, const MapType &type )
+{
+	if( bins.first == bins.second ) {
+		return 0;
+	}
+
+	switch( type ) {
+	case band_power: {
+		//by Parseval the variance of the series is the sum of 2|X_k|^2 / n^2 over all bins but the mean and the Nyquist bin
+		double sum = 0;
+
+		for( size_t k = bins.first; k < bins.second; k++ ) {
+			sum += ( 2 * k == n ) ? power[k] : 2 * power[k];
+		}
+
+		return sum / ( static_cast<double>( n ) * n );
+	}
+	case alff: {
+		double sum = 0;
+
+		for( size_t k = bins.first; k < bins.second; k++ ) {
+			sum += std::sqrt( power[k] );
+		}
+
+		return 2 * sum / ( static_cast<double>( n ) * ( bins.second - bins.first ) );
+	}
+	case falff: {
+		double band = 0, all = 0;
+		const size_t nc = Spectrum::getSpectrumSize( n );
+
+		for( size_t k = 1; k < nc; k++ ) {
+			const double amplitude = std::sqrt( power[k] );
+			all += amplitude;
+
+			if( k >= bins.first && k < bins.second ) {
+				band += amplitude;
+			}
+		}
+
+		return all > 0 ? band / all : 0;
+	}
+	}
+
+	return 0;
+}
+
+void BandPower::computeMap( const float *series, const size_t &stride, const util::FixedVector<size_t, 4> &size,
+							const double &repetitionTime, const double &lowFrequency, const double &highFrequency,
+							const MapType &type, float *dest )
+{
+	const size_t n = size[3];
+	const size_t nc = Spectrum::getSpectrumSize( n );
+	const size_t volume = size[0] * size[1] * size[2];
+	const std::pair<size_t, size_t> bins = getBins( n, repetitionTime, lowFrequency, highFrequency );
+	const int64_t numberOfBatches = ( volume + batchSize - 1 ) / batchSize;
+
+	#pragma omp parallel
+	{
+		//the plans of a Spectrum must not be used by several threads, so every thread gets its own
+		Spectrum spectrum;
+		std::vector<double> power( batchSize * nc );
+		#pragma omp for schedule( dynamic )
+
+		for( int64_t batch = 0; batch < numberOfBatches; batch++ ) {
+			const size_t start = batch * batchSize;
+			//only the last batch can be smaller, so there are at most two plans per thread
+			const size_t count = std::min<size_t>( batchSize, volume - start );
+			double *in = spectrum.getInput( n, count );
+
+			for( size_t i = 0; i < count; i++ ) {
+				const float *src = series + ( start + i ) * stride;
+				std::copy( src, src + n, in + i * n );
+			}
+
+			spectrum.execute( n, count, &power[0] );
+
+			for( size_t i = 0; i < count; i++ ) {
+				dest[start + i] = evaluate( &power[i * nc], n, bins, type );
+			}
+		}
+	}
+}
+
+}
+}
+}
@@ -0,0 +1,76 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * BandPower.hpp
+ *
+ * Description: band power and ALFF maps of functional images
+ *
+ ******************************************************************/
+#ifndef BANDPOWER_HPP
+#define BANDPOWER_HPP
+
+#include <CoreUtils/vector.hpp>
+#include <stdint.h>
+#include <utility>
+
+namespace isis
+{
+namespace viewer
+{
+namespace plugin
+{
+
+/**
+ * Computes a map of the spectral power of every voxel time series within a frequency band.
+ * The series are transformed in batches with one Spectrum object per thread, so the FFTW plans are created once per thread.
+ */
+class BandPower
+{
+public:
+	enum MapType { band_power, alff, falff };
+
+	/**
+	 * @param series the time-contiguous series as returned by ImageHolder::getTimeSeries
+	 * @param stride distance of two series in series
+	 * @param size size of the image, size[3] is the length of the series
+	 * @param repetitionTime sampling interval of the series in seconds
+	 * @param lowFrequency,highFrequency band in Hz. The mean (0 Hz) is never part of the band.
+	 * @param type band_power is the variance of the series within the band,
+	 * alff the mean amplitude within the band and falff the ratio of the amplitudes within the band and of all frequencies.
+	 * @param dest one value per voxel
+	 */
+	static void computeMap( const float *series, const size_t &stride, const util::FixedVector<size_t, 4> &size,
+							const double &repetitionTime, const double &lowFrequency, const double &highFrequency,
+							const MapType &type, float *dest );
+
+	///the range [first,last) of frequency bins of a series of length n within the band. It is empty if no bin is within the band.
+	static std::pair<size_t, size_t> getBins( const size_t &n, const double &repetitionTime, const double &lowFrequency, const double &highFrequency );
+
+private:
+	///number of series transformed together
+	static const size_t batchSize = 64;
+	static float evaluate( const double *power, const size_t &n, const std::pair<size_t, size_t> &bins, const MapType &type );
+};
+
+}
+}
+}
+
+#endif
@@ -28,10 +28,8 @@
 		
 #include "PlotterDialog.hpp"
 
-#include <fftw3.h>
-
 isis::viewer::plugin::PlotterDialog::PlotterDialog ( QWidget* parent, isis::viewer::QViewerCore* core ) 
-	: QDialog( parent ), m_ViewerCore( core ) {
+	: QDialog( parent ), m_ViewerCore( core ), m_Spectrum( core->getSettings() ) {
 	ui.setupUi( this );
 	ui.timeCourseRadio->setChecked( true );
 	plot = new QwtPlot( tr( "Timecourse" ), ui.widget );
@@ -52,6 +50,16 @@ isis::viewer::plugin::PlotterDialog::PlotterDialog ( QWidget* parent, isis::view
 	ui.comboAxis->addItem( "Y" );
 	ui.comboAxis->addItem( "Z" );
 	ui.comboAxis->addItem( "time" );
+	ui.comboMapType->addItem( "Band power", BandPower::band_power );
+	ui.comboMapType->addItem( "ALFF", BandPower::alff );
+	ui.comboMapType->addItem( "fALFF", BandPower::falff );
+	connect( ui.createMapButton, SIGNAL( clicked() ), this, SLOT( createBandPowerMap() ) );
+	connect( ui.comboMask, SIGNAL( currentIndexChanged(int) ), this, SLOT( updateScene() ) );
+	//polls for the time series of the ROI while they are built in the background
+	m_RoiTimer = new QTimer( this );
+	m_RoiTimer->setSingleShot( true );
+	m_RoiTimer->setInterval( 200 );
+	connect( m_RoiTimer, SIGNAL( timeout() ), this, SLOT( updateScene() ) );
 	if( m_ViewerCore->hasImage() ) {
 		refresh( m_ViewerCore->getCurrentImage()->physicalCoords );
 	}
@@ -64,6 +72,8 @@ isis::viewer::plugin::PlotterDialog::PlotterDialog ( QWidget* parent, isis::view
 void isis::viewer::plugin::PlotterDialog::showEvent ( QShowEvent* )
 {
 	if( m_ViewerCore->hasImage() ) {
+		//the time-contiguous copy is another full copy of the image, so it is only built for the ROI and the maps.
+		//Single time courses are read from the source image unless the copy already exists.
 		int i=3;
 		while ( m_ViewerCore->getCurrentImage()->getImageSize()[i] <= 1 && i >= 0 ) {
 			i--;
@@ -75,6 +85,8 @@ void isis::viewer::plugin::PlotterDialog::showEvent ( QShowEvent* )
 
 void isis::viewer::plugin::PlotterDialog::updateScene()
 {
+	//images can be added while the dialog is open, e.g. by the MaskEdit plugin
+	updateMaskList();
 	if( m_ViewerCore->hasImage() ) {
 		m_ViewerCore->getCurrentImage()->physicalCoords = m_ViewerCore->getCurrentImage()->getISISImage()->getPhysicalCoordsFromIndex( m_ViewerCore->getCurrentImage()->voxelCoords) ;
 		refresh( m_ViewerCore->getCurrentImage()->physicalCoords );
@@ -118,6 +130,9 @@ void isis::viewer::plugin::PlotterDialog::refresh ( isis::util::fvector4 physica
 				plot->setTitle( QString( "Image has only one timestep!" ) );
 			}
 		}
+		if( ui.comboAxis->currentIndex() == 3 ) {
+			fillRoi();
+		}
 		plot->replot();
 		plotMarker->detach();
 	}
@@ -158,81 +173,48 @@ void isis::viewer::plugin::PlotterDialog::fillProfile ( boost::shared_ptr< isis:
 	
 	QVector<double> xValues;
 	QVector<double> intensityValues;
-	using namespace isis::data;
-    util::ivector4 _coords = voxCoords;
-	for ( size_t i = 0; i < image->getImageSize()[axis]; i++ ) {
-		_coords[axis] = i;
-		if( axis != 3) {
-			xValues.push_back( image->getISISImage()->getPhysicalCoordsFromIndex(_coords)[ui.comboAxis->currentIndex()]);
-		} else {
-			xValues.push_back( factor * i );
-		}
-		switch( image->getISISImage()->getChunk( _coords[0], _coords[1], _coords[2], _coords[3] ).getTypeID() ) {
-		case ValuePtr<bool>::staticID:
-			fillVector<bool>( intensityValues, _coords, image );
-			break;
-		case ValuePtr<int8_t>::staticID:
-			fillVector<int8_t>( intensityValues, _coords, image );
-			break;
-		case ValuePtr<uint8_t>::staticID:
-			fillVector<uint8_t>( intensityValues, _coords, image );
-			break;
-		case ValuePtr<int16_t>::staticID:
-			fillVector<int16_t>( intensityValues, _coords, image );
-			break;
-		case ValuePtr<uint16_t>::staticID:
-			fillVector<uint16_t>( intensityValues, _coords, image );
-			break;
-		case ValuePtr<int32_t>::staticID:
-			fillVector<int32_t>( intensityValues, _coords, image );
-			break;
-		case ValuePtr<uint32_t>::staticID:
-			fillVector<uint32_t>( intensityValues, _coords, image );
-			break;
-		case ValuePtr<int64_t>::staticID:
-			fillVector<int64_t>( intensityValues, _coords, image );
-			break;
-		case ValuePtr<uint64_t>::staticID:
-			fillVector<uint64_t>( intensityValues, _coords, image );
-			break;
-		case ValuePtr<float>::staticID:
-			fillVector<float>( intensityValues, _coords, image );
-			break;
-		case ValuePtr<double>::staticID:
-			fillVector<double>( intensityValues, _coords, image );
-			break;
-		}
+	readProfile( image, voxCoords, axis, intensityValues );
+	//the physical coordinates are linear in the index, so only the first one and the step are computed
+	double start = 0;
+	double step = factor;
+	if( axis != 3 ) {
+		util::ivector4 _coords = voxCoords;
+		_coords[axis] = 0;
+		start = image->getISISImage()->getPhysicalCoordsFromIndex( _coords )[ui.comboAxis->currentIndex()];
+		step = image->getPhysicalStep( axis )[ui.comboAxis->currentIndex()];
+	}
+	xValues.resize( intensityValues.size() );
+	for ( int i = 0; i < xValues.size(); i++ ) {
+		xValues[i] = start + step * i;
 	}
 	curve->setData( xValues, intensityValues );
 
 }
 
+void isis::viewer::plugin::PlotterDialog::readProfile ( boost::shared_ptr< isis::viewer::ImageHolder > image, const isis::util::ivector4& voxCoords, const unsigned short &axis, QVector<double> &values )
+{
+	image->readProfile( voxCoords, axis, m_Profile );
+	values = QVector<double>::fromStdVector( m_Profile );
+}
+
 void isis::viewer::plugin::PlotterDialog::fillSpectrum ( boost::shared_ptr< isis::viewer::ImageHolder > image, const isis::util::ivector4& voxCoords, QwtPlotCurve* curve, const unsigned short &axis )
 {
 	plot->setAxisTitle( 2, tr( "1 / Hz" ) );
 	plot->setAxisTitle( 0, tr( "" ) );
 	
 	double powermin=10000000, powermax=-10000000;
-	fftw_plan plan;
 
-	size_t n = image->getImageSize()[3];
-	
-	const size_t nc = (n / 2 ) + 1;
-	double *in = (double *) fftw_malloc(sizeof(double) * n);
-	fftw_complex *out = (fftw_complex *) fftw_malloc (sizeof (fftw_complex ) * nc);
-	
-	plan = fftw_plan_dft_r2c_1d(n, in, out, FFTW_ESTIMATE);
-	util::ivector4 _coords = voxCoords;
-	for( size_t i = 0; i < n; i++ ) {
-		_coords[axis] = i;
-		in[i] = image->getISISImage()->voxel<int16_t>(_coords[0], _coords[1], _coords[2], _coords[3] );
-	}
-	
-	fftw_execute(plan); 
+	QVector<double> profile;
+	readProfile( image, voxCoords, axis, profile );
+	const size_t n = profile.size();
+	const size_t nc = Spectrum::getSpectrumSize( n );
+	//the plan for this length is created once and reused while the crosshair is moved
+	m_Spectrum.computePower( profile.constData(), n, 1, m_Power );
+
 	QVector<double> yVec(nc + 2);
 	QVector<double> xVec(nc + 2);
 	for (int k = 1; k < static_cast<int>(nc); k++) {
-      yVec[k] = (double)sqrt(out[k][0] * out[k][0] + out[k][1] * out[k][1]);
+      yVec[k] = sqrt( m_Power[k] );
 	  if (powermin>yVec[k]) powermin=yVec[k];
 	  if (powermax<yVec[k]) powermax=yVec[k];
 	  xVec[k] = k;
@@ -247,11 +229,181 @@ void isis::viewer::plugin::PlotterDialog::fillSpectrum ( boost::shared_ptr< isis
 	
 }
 
+void isis::viewer::plugin::PlotterDialog::createBandPowerMap()
+{
+	if( !m_ViewerCore->hasImage() ) {
+		return;
+	}
+
+	boost::shared_ptr<ImageHolder> functionalImage;
 
+	if( m_ViewerCore->getCurrentImage()->getImageSize()[3] > 1 ) {
+		functionalImage = m_ViewerCore->getCurrentImage();
+	} else {
+		BOOST_FOREACH( DataContainer::const_reference image, m_ViewerCore->getDataContainer() ) {
+			if( image.second->getImageSize()[3] > 1 ) {
+				functionalImage = image.second;
+			}
+		}
+	}
 
+	if( !functionalImage || functionalImage->isRGB ) {
+		QMessageBox msgBox;
+		msgBox.setText( "Can not find any functional dataset. Will not calculate the band power map!" );
+		msgBox.exec();
+		return;
+	}
 
+	const util::FixedVector<size_t, 4> size = functionalImage->getImageSize();
+	double repetitionTime = 1;
 
+	if( functionalImage->getISISImage()->hasProperty( "repetitionTime" ) ) {
+		repetitionTime = functionalImage->getISISImage()->getPropertyAs<double>( "repetitionTime" ) / 1000;
+	} else {
+		LOG( Runtime, warning ) << functionalImage->getFileNames().front() << " has no repetitionTime. Assuming 1 s.";
+	}
 
+	const BandPower::MapType type = static_cast<BandPower::MapType>( ui.comboMapType->itemData( ui.comboMapType->currentIndex() ).toInt() );
+	const double lowFrequency = ui.lowFrequency->value();
+	const double highFrequency = ui.highFrequency->value();
 
+	const std::pair<size_t, size_t> bins = BandPower::getBins( size[3], repetitionTime, lowFrequency, highFrequency );
 
+	if( bins.first == bins.second ) {
+		QMessageBox msgBox;
+		msgBox.setText( "The frequency band does not contain any frequency of the time series!" );
+		msgBox.exec();
+		return;
+	}
 
+	QApplication::setOverrideCursor( Qt::WaitCursor );
+	data::MemChunk<float> ch( size[0], size[1], size[2] );
+	ch.join( static_cast<isis::util::PropertyMap &>( *functionalImage->getISISImage() ) );
+
+	if( !ch.hasProperty( "acquisitionNumber" ) ) {
+		ch.setPropertyAs<uint16_t>( "acquisitionNumber", 0 );
+	}
+
+	BandPower::computeMap( functionalImage->getTimeSeries( true ), functionalImage->getTimeSeriesStride(), size,
+						   repetitionTime, lowFrequency, highFrequency, type, &ch.voxel<float>( 0, 0, 0 ) );
+	data::Image map( ch );
+	std::stringstream source;
+	source << ui.comboMapType->currentText().toStdString() << "_" << lowFrequency << "_" << highFrequency << "Hz";
+	map.setPropertyAs<std::string>( "source", source.str() );
+	boost::shared_ptr<ImageHolder> mapImage = m_ViewerCore->addImage( map, ImageHolder::z_map );
+	QApplication::restoreOverrideCursor();
+
+	BOOST_FOREACH( UICore::ViewWidgetEnsembleListType::const_reference ensemble, m_ViewerCore->getUICore()->getEnsembleList() ) {
+		for( unsigned short i = 0; i < 3; i++ ) {
+			const WidgetInterface::ImageVectorType iVector = ensemble[i].widgetImplementation->getImageVector();
+
+			if( std::find( iVector.begin(), iVector.end(), functionalImage ) != iVector.end() ) {
+				m_ViewerCore->attachImageToWidget( mapImage, ensemble[i].widgetImplementation );
+			}
+		}
+	}
+
+	if( m_ViewerCore->getMode() != ViewerCoreBase::zmap ) {
+		m_ViewerCore->setMode( ViewerCoreBase::zmap );
+	}
+
+	m_ViewerCore->getUICore()->refreshUI();
+	m_ViewerCore->updateScene();
+}
+
+void isis::viewer::plugin::PlotterDialog::updateMaskList()
+{
+	const QString current = ui.comboMask->itemData( ui.comboMask->currentIndex() ).toString();
+	ui.comboMask->blockSignals( true );
+	ui.comboMask->clear();
+	ui.comboMask->addItem( tr( "none" ), QString() );
+	BOOST_FOREACH( DataContainer::const_reference image, m_ViewerCore->getDataContainer() ) {
+		if( image.second->getImageSize()[3] == 1 && !image.second->isRGB ) {
+			const QString key = QString::fromStdString( image.first );
+			ui.comboMask->addItem( QFileInfo( key ).fileName(), key );
+		}
+	}
+	ui.comboMask->setCurrentIndex( std::max( 0, ui.comboMask->findData( current ) ) );
+	ui.comboMask->blockSignals( false );
+}
+
+void isis::viewer::plugin::PlotterDialog::fillRoi()
+{
+	const std::string maskKey = ui.comboMask->itemData( ui.comboMask->currentIndex() ).toString().toStdString();
+	const DataContainer &dataContainer = m_ViewerCore->getDataContainer();
+	const DataContainer::const_iterator maskIter = dataContainer.find( maskKey );
+	boost::shared_ptr<ImageHolder> functionalImage;
+
+	if( m_ViewerCore->getCurrentImage()->getImageSize()[3] > 1 ) {
+		functionalImage = m_ViewerCore->getCurrentImage();
+	} else {
+		BOOST_FOREACH( DataContainer::const_reference image, dataContainer ) {
+			if( image.second->getImageSize()[3] > 1 ) {
+				functionalImage = image.second;
+			}
+		}
+	}
+
+	if( maskKey.empty() || maskIter == dataContainer.end() || !functionalImage || functionalImage->isRGB ) {
+		m_RoiTimeCourse.reset();
+		return;
+	}
+
+	//only recomputed if the mask has been edited since the last call
+	m_RoiTimeCourse.update( functionalImage, maskIter->second );
+
+	if( m_RoiTimeCourse.isPending() ) {
+		m_RoiTimer->start();
+	}
+
+	if( !m_RoiTimeCourse.getNumberOfVoxels() ) {
+		return;
+	}
+
+	const std::vector<double> &mean = m_RoiTimeCourse.getMean();
+	const std::vector<double> &deviation = m_RoiTimeCourse.getStandardDeviation();
+	QPen pen( Qt::blue );
+	pen.setWidth( 2 );
+
+	if( ui.spectrumRadio->isChecked() ) {
+		m_Spectrum.computePower( &mean[0], mean.size(), 1, m_Power );
+		QVector<double> xVec( m_Power.size() - 1 ), yVec( m_Power.size() - 1 );
+		for( int k = 0; k < xVec.size(); k++ ) {
+			xVec[k] = k + 1;
+			yVec[k] = sqrt( m_Power[k + 1] );
+		}
+		QwtPlotCurve *curve = new QwtPlotCurve( tr( "ROI mean" ) );
+		curve->setData( xVec, yVec );
+		curve->setPen( pen );
+		curve->attach( plot );
+		return;
+	}
+
+	float factor = 1;
+	if ( functionalImage->getISISImage()->hasProperty( "repetitionTime" ) ) {
+		factor = ( float )functionalImage->getISISImage()->getPropertyAs<uint16_t>( "repetitionTime" ) / 1000;
+	}
+	const int n = mean.size();
+	QVector<double> xValues( n ), meanValues( n ), upperValues( n ), lowerValues( n );
+	for( int t = 0; t < n; t++ ) {
+		xValues[t] = factor * t;
+		meanValues[t] = mean[t];
+		upperValues[t] = mean[t] + deviation[t];
+		lowerValues[t] = mean[t] - deviation[t];
+	}
+
+	QwtPlotCurve *meanCurve = new QwtPlotCurve( tr( "ROI mean" ) );
+	meanCurve->setData( xValues, meanValues );
+	meanCurve->setPen( pen );
+	meanCurve->attach( plot );
+	pen.setWidth( 1 );
+	pen.setStyle( Qt::DashLine );
+	QwtPlotCurve *upperCurve = new QwtPlotCurve( tr( "ROI mean + sd" ) );
+	upperCurve->setData( xValues, upperValues );
+	upperCurve->setPen( pen );
+	upperCurve->attach( plot );
+	QwtPlotCurve *lowerCurve = new QwtPlotCurve( tr( "ROI mean - sd" ) );
+	lowerCurve->setData( xValues, lowerValues );
+	lowerCurve->setPen( pen );
+	lowerCurve->attach( plot );
+}
@@ -39,6 +39,9 @@
 #include <iostream>
 #include "qviewercore.hpp"
 #include "DataStorage/typeptr.hpp"
+#include "Spectrum.hpp"
+#include "BandPower.hpp"
+#include "RoiTimeCourse.hpp"
 
 namespace isis
 {
@@ -57,6 +60,10 @@ public Q_SLOTS:
 	void updateScene();
 
 	virtual void refresh( util::fvector4 physicalCoords );
+	///computes the map selected in the dialog for all voxels of the functional image and adds it as z map
+	void createBandPowerMap();
+	///fills the ROI selection with all images that have one timestep
+	void updateMaskList();
 	
 private:
 	Ui::plottingDialog ui;
@@ -65,14 +72,18 @@ private:
 	QwtPlotMarker *plotMarker;
 	QViewerCore *m_ViewerCore;
 	util::fvector4 m_CurrentPhysicalCoords;
+	Spectrum m_Spectrum;
+	std::vector<double> m_Power;
+	std::vector<double> m_Profile;
+	RoiTimeCourse m_RoiTimeCourse;
+	QTimer *m_RoiTimer;
 	
 	void fillProfile( boost::shared_ptr<ImageHolder> image, const util::ivector4 &voxCoords, QwtPlotCurve *curve, const unsigned short &axis );
 	void fillSpectrum(  boost::shared_ptr<ImageHolder> image, const util::ivector4 &voxCoords, QwtPlotCurve *curve, const unsigned short &axis ); 
-	
-	template<typename TYPE>
-	void fillVector( QVector<double> &iv, const util::ivector4 &vox, boost::shared_ptr<ImageHolder> image ) {
-		iv.push_back( image->getISISImage()->voxel<TYPE>( vox[0], vox[1], vox[2], vox[3] ) );
-	}
+	///adds the mean and standard deviation time course ( or the spectrum of the mean ) of the selected ROI to the plot
+	void fillRoi();
+	///reads the values along axis through voxCoords with ImageHolder::readProfile
+	void readProfile( boost::shared_ptr<ImageHolder> image, const util::ivector4 &voxCoords, const unsigned short &axis, QVector<double> &values );
 
 };
 
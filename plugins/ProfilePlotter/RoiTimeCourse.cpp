@@ -0,0 +1,225 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * RoiTimeCourse.cpp
+ *
+ * Description: mean and standard deviation time course of the voxels of a mask
+ *
+ ******************************************************************/
+#include "RoiTimeCourse.hpp"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace isis
+{
+namespace viewer
+{
+namespace plugin
+{
+
+RoiTimeCourse::RoiTimeCourse()
+	: m_MaskRevision( std::numeric_limits<size_t>::max() ),
+	  m_Pending( false ),
+	  m_NumberOfVoxels( 0 )
+{}
+
+void RoiTimeCourse::reset()
+{
+	m_Image.reset();
+	m_Mask.reset();
+	m_MaskRevision = std::numeric_limits<size_t>::max();
+	m_Pending = false;
+	m_MaskVoxels.clear();
+	m_Counts.clear();
+	m_NumberOfVoxels = 0;
+	m_Sum.clear();
+	m_SumOfSquares.clear();
+	m_Mean.clear();
+	m_StandardDeviation.clear();
+}
+
+bool RoiTimeCourse::update( boost::shared_ptr<ImageHolder> image, boost::shared_ptr<ImageHolder> mask )
+{
+	if( image != m_Image.lock() || mask != m_Mask.lock() ) {
+		reset();
+		m_Image = image;
+		m_Mask = mask;
+	}
+
+	m_Pending = false;
+
+	if( !image || !mask || mask->getDataRevision() == m_MaskRevision ) {
+		return false;
+	}
+
+	//building the time-contiguous copy takes a while for large images, so the GUI thread does not wait for it
+	image->requestTimeSeries();
+	const float *series = image->getTimeSeries();
+
+	if( !series ) {
+		m_Pending = true;
+		return false;
+	}
+
+	const util::FixedVector<size_t, 4> size = image->getImageSize();
+	const util::FixedVector<size_t, 4> maskSize = mask->getImageSize();
+	const size_t n = size[3];
+	const size_t stride = image->getTimeSeriesStride();
+	util::ivector4 start, end;
+
+	if( m_Counts.empty() || !mask->getChangedRegion( m_MaskRevision, start, end ) ) {
+		m_MaskVoxels.assign( maskSize[0] * maskSize[1] * maskSize[2], false );
+		m_Counts.assign( size[0] * size[1] * size[2], 0 );
+		m_NumberOfVoxels = 0;
+		m_Sum.clear();
+		start = util::ivector4();
+		end = util::ivector4( maskSize[0] - 1, maskSize[1] - 1, maskSize[2] - 1, 0 );
+	}
+
+	std::vector<size_t> added, removed;
+	updateVoxels( *image, *mask, start, end, added, removed );
+
+	//summing up the whole region again is cheaper if most of it has changed
+	if( m_Sum.size() != n || added.size() + removed.size() > m_NumberOfVoxels ) {
+		std::vector<size_t> voxels;
+		voxels.reserve( m_NumberOfVoxels );
+
+		for( size_t i = 0; i < m_Counts.size(); i++ ) {
+			if( m_Counts[i] ) {
+				voxels.push_back( i );
+			}
+		}
+
+		m_Sum.assign( n, 0 );
+		m_SumOfSquares.assign( n, 0 );
+		accumulate( series, stride, voxels, 1 );
+	} else {
+		accumulate( series, stride, added, 1 );
+		accumulate( series, stride, removed, -1 );
+	}
+
+	m_MaskRevision = mask->getDataRevision();
+	m_Mean.assign( n, 0 );
+	m_StandardDeviation.assign( n, 0 );
+
+	if( m_NumberOfVoxels ) {
+		for( size_t t = 0; t < n; t++ ) {
+			m_Mean[t] = m_Sum[t] / m_NumberOfVoxels;
+			m_StandardDeviation[t] = std::sqrt( std::max<double>( 0, m_SumOfSquares[t] / m_NumberOfVoxels - m_Mean[t] * m_Mean[t] ) );
+		}
+	}
+
+	return true;
+}
+
+void RoiTimeCourse::updateVoxels( const ImageHolder &image, ImageHolder &mask, const util::ivector4 &start, const util::ivector4 &end,
+								  std::vector<size_t> &added, std::vector<size_t> &removed )
+{
+	const util::FixedVector<size_t, 4> size = image.getImageSize();
+	const util::FixedVector<size_t, 4> maskSize = mask.getImageSize();
+	const data::Image &functionalImage = *image.getISISImage();
+	//the physical coordinates are linear in the index, so they are computed from the origin and the steps of the mask
+	const util::fvector4 origin = mask.getISISImage()->getPhysicalCoordsFromIndex( util::ivector4() );
+	const util::fvector4 steps[3] = { mask.getPhysicalStep( 0 ), mask.getPhysicalStep( 1 ), mask.getPhysicalStep( 2 ) };
+	std::vector<double> row;
+	util::ivector4 coords;
+
+	for( int32_t z = start[2]; z <= end[2]; z++ ) {
+		for( int32_t y = start[1]; y <= end[1]; y++ ) {
+			coords[1] = y;
+			coords[2] = z;
+			mask.readProfile( coords, 0, row );
+
+			for( int32_t x = start[0]; x <= end[0]; x++ ) {
+				const bool inside = row[x] != 0;
+				const size_t maskIndex = ( z * maskSize[1] + y ) * maskSize[0] + x;
+
+				if( inside == m_MaskVoxels[maskIndex] ) {
+					continue;
+				}
+
+				m_MaskVoxels[maskIndex] = inside;
+				util::fvector4 physicalCoords;
+
+				for( unsigned short i = 0; i < 4; i++ ) {
+					physicalCoords[i] = origin[i] + steps[0][i] * x + steps[1][i] * y + steps[2][i] * z;
+				}
+
+				const util::ivector4 index = functionalImage.getIndexFromPhysicalCoords( physicalCoords, false );
+
+				if( index[0] < 0 || index[1] < 0 || index[2] < 0 ||
+					index[0] >= static_cast<int32_t>( size[0] ) || index[1] >= static_cast<int32_t>( size[1] ) || index[2] >= static_cast<int32_t>( size[2] ) ) {
+					continue;
+				}
+
+				//several mask voxels fall into the same voxel if the mask has a higher resolution
+				const size_t voxel = ( index[2] * size[1] + index[1] ) * size[0] + index[0];
+
+				if( inside ) {
+					if( !m_Counts[voxel]++ ) {
+						added.push_back( voxel );
+						m_NumberOfVoxels++;
+					}
+				} else if( !--m_Counts[voxel] ) {
+					removed.push_back( voxel );
+					m_NumberOfVoxels--;
+				}
+			}
+		}
+	}
+}
+
+void RoiTimeCourse::accumulate( const float *series, const size_t &stride, const std::vector<size_t> &voxels, const double &sign )
+{
+	const size_t n = m_Sum.size();
+	const int64_t count = voxels.size();
+
+	if( !count ) {
+		return;
+	}
+
+	#pragma omp parallel
+	{
+		std::vector<double> sum( n, 0 ), sumOfSquares( n, 0 );
+		#pragma omp for schedule( static )
+
+		for( int64_t i = 0; i < count; i++ ) {
+			const float *voxelSeries = series + voxels[i] * stride;
+
+			for( size_t t = 0; t < n; t++ ) {
+				sum[t] += voxelSeries[t];
+				sumOfSquares[t] += static_cast<double>( voxelSeries[t] ) * voxelSeries[t];
+			}
+		}
+
+		#pragma omp critical
+		{
+			for( size_t t = 0; t < n; t++ ) {
+				m_Sum[t] += sign * sum[t];
+				m_SumOfSquares[t] += sign * sumOfSquares[t];
+			}
+		}
+	}
+}
+
+}
+}
+}
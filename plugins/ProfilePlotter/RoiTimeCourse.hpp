@@ -0,0 +1,93 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * RoiTimeCourse.hpp
+ *
+ * Description: mean and standard deviation time course of the voxels of a mask
+ *
+ ******************************************************************/
+#ifndef ROITIMECOURSE_HPP
+#define ROITIMECOURSE_HPP
+
+#include "imageholder.hpp"
+#include <boost/weak_ptr.hpp>
+#include <vector>
+
+namespace isis
+{
+namespace viewer
+{
+namespace plugin
+{
+
+/**
+ * Mean and standard deviation time course of all voxels of a functional image that are nonzero in a mask image.
+ * The mask is mapped to the functional image by the physical coordinates, so both may have different resolutions.
+ * For every voxel of the functional image the number of mask voxels that fall into it is counted. If the mask is edited,
+ * only the region that has changed is read again and only the voxels that were added or removed change the sums,
+ * so painting a mask stays interactive for large regions.
+ * The time courses are computed from the time-contiguous copy of the functional image. As long as it is being built
+ * in the background update returns false and isPending is true.
+ */
+class RoiTimeCourse
+{
+public:
+	RoiTimeCourse();
+
+	/**
+	 * Updates the time courses if image or mask are different from the last call or the mask has been changed.
+	 * Returns true if the time courses have been updated.
+	 */
+	bool update( boost::shared_ptr<ImageHolder> image, boost::shared_ptr<ImageHolder> mask );
+	void reset();
+
+	///true if the last update had to wait for the time-contiguous copy of the functional image
+	bool isPending() const { return m_Pending; }
+	const std::vector<double> &getMean() const { return m_Mean; }
+	const std::vector<double> &getStandardDeviation() const { return m_StandardDeviation; }
+	size_t getNumberOfVoxels() const { return m_NumberOfVoxels; }
+
+private:
+	boost::weak_ptr<ImageHolder> m_Image;
+	boost::weak_ptr<ImageHolder> m_Mask;
+	size_t m_MaskRevision;
+	bool m_Pending;
+	///mask voxels that are counted in m_Counts
+	std::vector<bool> m_MaskVoxels;
+	///number of mask voxels within each voxel of the functional image
+	std::vector<uint32_t> m_Counts;
+	size_t m_NumberOfVoxels;
+	std::vector<double> m_Sum;
+	std::vector<double> m_SumOfSquares;
+	std::vector<double> m_Mean;
+	std::vector<double> m_StandardDeviation;
+
+	///reads the mask in the box from start to end and collects the voxels of the functional image that enter or leave the region
+	void updateVoxels( const ImageHolder &image, ImageHolder &mask, const util::ivector4 &start, const util::ivector4 &end,
+					   std::vector<size_t> &added, std::vector<size_t> &removed );
+	///adds ( sign 1 ) or subtracts ( sign -1 ) the series of the voxels from the sums with a parallel reduction
+	void accumulate( const float *series, const size_t &stride, const std::vector<size_t> &voxels, const double &sign );
+};
+
+}
+}
+}
+
+#endif
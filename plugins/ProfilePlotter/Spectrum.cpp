@@ -0,0 +1,121 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * Spectrum.cpp
+ *
+ * Description: cached FFTW plans for power spectra of time series
+ *
+ ******************************************************************/
+#include "Spectrum.hpp"
+#include <CoreUtils/log.hpp>
+#include "common.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace isis
+{
+namespace viewer
+{
+namespace plugin
+{
+
+QMutex Spectrum::m_PlannerMutex;
+
+Spectrum::Spectrum( QSettings *settings )
+	: m_Settings( settings )
+{
+	if( m_Settings ) {
+		QMutexLocker locker( &m_PlannerMutex );
+		const QByteArray wisdom = m_Settings->value( "fftwWisdom" ).toByteArray();
+
+		if( !wisdom.isEmpty() && !fftw_import_wisdom_from_string( wisdom.constData() ) ) {
+			LOG( Dev, warning ) << "Could not import the stored FFTW wisdom";
+		}
+	}
+}
+
+Spectrum::~Spectrum()
+{
+	QMutexLocker locker( &m_PlannerMutex );
+
+	for( PlanMapType::iterator iter = m_Plans.begin(); iter != m_Plans.end(); iter++ ) {
+		fftw_destroy_plan( iter->second.plan );
+		fftw_free( iter->second.in );
+		fftw_free( iter->second.out );
+	}
+}
+
+Spectrum::Plan &Spectrum::getPlan( const size_t &n, const size_t &count )
+{
+	const std::pair<size_t, size_t> key( n, count );
+	PlanMapType::iterator iter = m_Plans.find( key );
+
+	if( iter != m_Plans.end() ) {
+		return iter->second;
+	}
+
+	const size_t nc = getSpectrumSize( n );
+	Plan plan;
+	plan.in = static_cast<double *>( fftw_malloc( sizeof( double ) * n * count ) );
+	plan.out = static_cast<fftw_complex *>( fftw_malloc( sizeof( fftw_complex ) * nc * count ) );
+	QMutexLocker locker( &m_PlannerMutex );
+	//measuring overwrites the buffers, so this has to be done before they are filled
+	const int length = n;
+	plan.plan = fftw_plan_many_dft_r2c( 1, &length, count, plan.in, 0, 1, n, plan.out, 0, 1, nc, m_Settings ? FFTW_MEASURE : FFTW_ESTIMATE );
+
+	if( m_Settings ) {
+		char *wisdom = fftw_export_wisdom_to_string();
+
+		if( wisdom ) {
+			m_Settings->setValue( "fftwWisdom", QByteArray( wisdom ) );
+			free( wisdom );
+		}
+	}
+
+	LOG( Dev, verbose_info ) << "Created FFTW plan for " << count << " series of length " << n;
+	return m_Plans[key] = plan;
+}
+
+double *Spectrum::getInput( const size_t &n, const size_t &count )
+{
+	return getPlan( n, count ).in;
+}
+
+void Spectrum::execute( const size_t &n, const size_t &count, double *power )
+{
+	const Plan &plan = getPlan( n, count );
+	const size_t size = getSpectrumSize( n ) * count;
+	fftw_execute( plan.plan );
+
+	for( size_t k = 0; k < size; k++ ) {
+		power[k] = plan.out[k][0] * plan.out[k][0] + plan.out[k][1] * plan.out[k][1];
+	}
+}
+
+void Spectrum::computePower( const double *series, const size_t &n, const size_t &count, std::vector<double> &power )
+{
+	std::copy( series, series + n * count, getInput( n, count ) );
+	power.resize( getSpectrumSize( n ) * count );
+	execute( n, count, &power[0] );
+}
+
+}
+}
+}
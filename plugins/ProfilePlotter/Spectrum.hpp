@@ -0,0 +1,91 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * Spectrum.hpp
+ *
+ * Description: cached FFTW plans for power spectra of time series
+ *
+ ******************************************************************/
+#ifndef SPECTRUM_HPP
+#define SPECTRUM_HPP
+
+#include <fftw3.h>
+#include <boost/noncopyable.hpp>
+#include <QMutex>
+#include <QSettings>
+#include <vector>
+#include <map>
+
+namespace isis
+{
+namespace viewer
+{
+namespace plugin
+{
+
+/**
+ * Computes power spectra of time series with FFTW.
+ * The plans and their aligned buffers are created once per series length and batch size and are reused for all following calls.
+ * If settings are given, the plans are measured and the FFTW wisdom is stored there, so measuring is only done once per length.
+ * An object of this class must only be used by one thread at a time. Every thread that computes spectra should have its own.
+ */
+class Spectrum : boost::noncopyable
+{
+public:
+	Spectrum( QSettings *settings = 0 );
+	~Spectrum();
+
+	///number of values of the spectrum of a series of length n
+	static size_t getSpectrumSize( const size_t &n ) { return n / 2 + 1; }
+
+	/**
+	 * Computes the power spectra of count series of length n in one batched transform.
+	 * The series are stored one after another in series. power is resized to count * getSpectrumSize( n ).
+	 */
+	void computePower( const double *series, const size_t &n, const size_t &count, std::vector<double> &power );
+
+	/**
+	 * Returns the input buffer for count series of length n. Writing the series directly into it and calling
+	 * execute avoids copying them.
+	 */
+	double *getInput( const size_t &n, const size_t &count );
+	///transforms the series in the input buffer of n and count and writes their power spectra to power
+	void execute( const size_t &n, const size_t &count, double *power );
+
+private:
+	struct Plan {
+		fftw_plan plan;
+		double *in;
+		fftw_complex *out;
+	};
+	typedef std::map<std::pair<size_t, size_t>, Plan> PlanMapType;
+	PlanMapType m_Plans;
+	QSettings *m_Settings;
+
+	Plan &getPlan( const size_t &n, const size_t &count );
+	///the FFTW planner is not thread safe
+	static QMutex m_PlannerMutex;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,173 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * vastcorrelation.cpp
+ *
+ * Description: writes seed based correlation maps of a functional image without the GUI
+ *
+ ******************************************************************/
+#include <CoreUtils/application.hpp>
+#include <CoreUtils/log.hpp>
+#include <DataStorage/io_factory.hpp>
+#include <DataStorage/image.hpp>
+#include <boost/filesystem.hpp>
+
+#include "correlation.hpp"
+
+using namespace isis;
+using namespace isis::viewer;
+
+namespace
+{
+
+bool writeMap( const data::Image &image, const operation::Correlation &correlation, const std::string &path )
+{
+	const util::FixedVector<size_t, 4> size = image.getSizeAsVector();
+	data::MemChunk<float> ch( size[0], size[1], size[2] );
+	ch.join( static_cast<const util::PropertyMap &>( image ) );
+
+	if( !ch.hasProperty( "acquisitionNumber" ) ) {
+		ch.setPropertyAs<uint16_t>( "acquisitionNumber", 0 );
+	}
+
+	correlation.computeMap( &ch.voxel<float>( 0, 0, 0 ) );
+	data::Image corrMap( ch );
+	corrMap.setPropertyAs<std::string>( "source", "correlation_map" );
+
+	if( !data::IOFactory::write( corrMap, path ) ) {
+		LOG( Runtime, error ) << "Could not write the correlation map " << path << "!";
+		return false;
+	}
+
+	LOG( Runtime, info ) << "Wrote the correlation map " << path;
+	return true;
+}
+
+}
+
+int main( int argc, char *argv[] )
+{
+	util::Application app( "vastcorrelation" );
+	app.parameters["in"] = std::string();
+	app.parameters["in"].needed() = true;
+	app.parameters["in"].setDescription( "The functional image." );
+	app.parameters["out"] = std::string();
+	app.parameters["out"].needed() = true;
+	app.parameters["out"].setDescription( "Path of the correlation maps. The seed coordinates (or \"roi\") are appended to the file name." );
+	app.parameters["seeds"] = util::ilist();
+	app.parameters["seeds"].needed() = false;
+	app.parameters["seeds"].setDescription( "Voxel coordinates of the seeds as a list of x y z triples." );
+	app.parameters["mask"] = std::string();
+	app.parameters["mask"].needed() = false;
+	app.parameters["mask"].setDescription( "ROI mask. The mean time series of all nonzero voxels is used as seed." );
+	app.init( argc, argv, true );
+
+	util::_internal::Log<viewer::Runtime>::setHandler( boost::shared_ptr<util::MessageHandlerBase>( new util::DefaultMsgPrint( info ) ) );
+
+	const util::ilist seedList = app.parameters["seeds"];
+	const std::string maskFile = app.parameters["mask"].toString();
+
+	if( seedList.size() % 3 ) {
+		LOG( Runtime, error ) << "The seeds have to be given as x y z triples!";
+		return EXIT_FAILURE;
+	}
+
+	if( seedList.empty() && maskFile.empty() ) {
+		LOG( Runtime, error ) << "Neither seeds nor a mask were given!";
+		return EXIT_FAILURE;
+	}
+
+	const std::list<data::Image> images = data::IOFactory::load( app.parameters["in"].toString() );
+
+	if( images.empty() ) {
+		LOG( Runtime, error ) << "Could not load " << app.parameters["in"].toString() << "!";
+		return EXIT_FAILURE;
+	}
+
+	const data::Image &image = images.front();
+	const util::FixedVector<size_t, 4> size = image.getSizeAsVector();
+
+	if( size[3] < 2 ) {
+		LOG( Runtime, error ) << app.parameters["in"].toString() << " has only one timestep!";
+		return EXIT_FAILURE;
+	}
+
+	const size_t volume = size[0] * size[1] * size[2];
+	std::vector<float> seriesBuffer( volume * operation::Correlation::getStride( size[3] ) + 8, 0 );
+	float *series = reinterpret_cast<float *>( ( reinterpret_cast<uintptr_t>( &seriesBuffer[0] ) + 31 ) & ~static_cast<uintptr_t>( 31 ) );
+	operation::Correlation::createTimeSeries( image, series );
+	operation::Correlation correlation( series, size );
+
+	const std::string out = app.parameters["out"].toString();
+	const std::string extension = boost::filesystem::extension( boost::filesystem::path( out ) );
+	const std::string base = out.substr( 0, out.size() - extension.size() );
+	bool success = true;
+
+	for( util::ilist::const_iterator iter = seedList.begin(); iter != seedList.end(); ) {
+		const int32_t x = *iter++;
+		const int32_t y = *iter++;
+		const int32_t z = *iter++;
+
+		if( x < 0 || y < 0 || z < 0 || x >= static_cast<int32_t>( size[0] ) || y >= static_cast<int32_t>( size[1] ) || z >= static_cast<int32_t>( size[2] ) ) {
+			LOG( Runtime, error ) << "The seed " << x << " " << y << " " << z << " is outside of the image!";
+			success = false;
+			continue;
+		}
+
+		correlation.setSeed( ( z * size[1] + y ) * size[0] + x );
+		std::stringstream path;
+		path << base << "_" << x << "_" << y << "_" << z << extension;
+		success &= writeMap( image, correlation, path.str() );
+	}
+
+	if( !maskFile.empty() ) {
+		const std::list<data::Image> masks = data::IOFactory::load( maskFile );
+
+		if( masks.empty() ) {
+			LOG( Runtime, error ) << "Could not load the mask " << maskFile << "!";
+			return EXIT_FAILURE;
+		}
+
+		const util::FixedVector<size_t, 4> maskSize = masks.front().getSizeAsVector();
+
+		//the voxels of the mask are used as indices into the functional image, so both have to have the same shape
+		if( maskSize[0] != size[0] || maskSize[1] != size[1] || maskSize[2] != size[2] ) {
+			LOG( Runtime, error ) << "The mask " << maskFile << " has the size " << maskSize
+								  << " which does not match the size " << size << " of the functional image!";
+			return EXIT_FAILURE;
+		}
+
+		std::vector<float> maskValues( masks.front().getVolume() );
+		masks.front().copyToMem<float>( &maskValues[0], maskValues.size() );
+		std::vector<size_t> roi;
+
+		for( size_t voxel = 0; voxel < volume; voxel++ ) {
+			if( maskValues[voxel] ) {
+				roi.push_back( voxel );
+			}
+		}
+
+		LOG( Runtime, info ) << "The mask " << maskFile << " has " << roi.size() << " voxels.";
+		correlation.setSeed( roi );
+		success &= writeMap( image, correlation, base + "_roi" + extension );
+	}
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -31,6 +31,7 @@
 #include <QResource>
 #include <QFile>
 #include <fstream>
+#include <algorithm>
 #include <boost/iostreams/filter/newline.hpp>
 
 
@@ -41,6 +42,34 @@ namespace viewer
 namespace color
 {
 
+ColormapParameters::ColormapParameters()
+	: min( 0 ), max( 0 ), extent( 0 ), scaling( 1 ), offset( 0 ), lowerThreshold( 0 ), upperThreshold( 0 ), indexScaling( 1 ), indexOffset( 0 ), zmap( false ), split( true )
+{}
+
+bool ColormapParameters::operator==( const ColormapParameters &other ) const
+{
+	return min == other.min && max == other.max && extent == other.extent && scaling == other.scaling && offset == other.offset
+		   && lowerThreshold == other.lowerThreshold && upperThreshold == other.upperThreshold
+		   && indexScaling == other.indexScaling && indexOffset == other.indexOffset && zmap == other.zmap && split == other.split
+		   && lut == other.lut;
+}
+
+bool ColormapParameters::operator<( const ColormapParameters &other ) const
+{
+	const double values[] = { min, max, extent, scaling, offset, lowerThreshold, upperThreshold, indexScaling, indexOffset, static_cast<double>( zmap ), static_cast<double>( split ) };
+	const double otherValues[] = { other.min, other.max, other.extent, other.scaling, other.offset, other.lowerThreshold, other.upperThreshold,
+								   other.indexScaling, other.indexOffset, static_cast<double>( other.zmap ), static_cast<double>( other.split )
+								 };
+
+	for( size_t i = 0; i < sizeof( values ) / sizeof( double ); i++ ) {
+		if( values[i] != otherValues[i] ) {
+			return values[i] < otherValues[i];
+		}
+	}
+
+	return lut < other.lut;
+}
+
 void Color::initStandardColormaps()
 {
 	addColormap( std::string( ":/colormap/lut/colormap1" ) );
@@ -125,7 +154,9 @@ bool Color::addColormap( const std::string &path, const boost::regex &separator
 		return false;
 	}
 
+	QMutexLocker locker( &m_AdaptedColormapsMutex );
 	m_ColormapMap[lutName] = lutVec;
+	m_AdaptedColormaps.clear();
 	LOG( Dev, verbose_info ) << "Added colormap " << path;
 	return true;
 }
@@ -197,29 +228,90 @@ Color::ColormapType Color::getFallbackColormap() const
 }
 
 
+ColormapParameters Color::getColormapParameters( const ImageHolder *image, bool split )
+{
+	ColormapParameters parameters;
+	parameters.lut = image->lut;
+	parameters.min = image->minMax.first->as<double>();
+	parameters.max = image->minMax.second->as<double>();
+	parameters.extent = image->extent;
+	parameters.scaling = image->scaling;
+	parameters.offset = image->offset;
+	parameters.lowerThreshold = image->lowerThreshold;
+	parameters.upperThreshold = image->upperThreshold;
+	parameters.indexScaling = image->getColormapIndexScaling();
+	parameters.indexOffset = image->getColormapIndexOffset();
+	parameters.zmap = image->imageType == ImageHolder::z_map;
+	parameters.split = split;
+	return parameters;
+}
+
+Color::ColormapType Color::getAdaptedColormap( const ColormapParameters &parameters )
+{
+	QMutexLocker locker( &m_AdaptedColormapsMutex );
+	std::map<ColormapParameters, ColormapType>::const_iterator iter = m_AdaptedColormaps.find( parameters );
+
+	if( iter != m_AdaptedColormaps.end() ) {
+		return iter->second;
+	}
+
+	//dragging the window/level creates a new entry for every step, so the cache is not allowed to grow without limit
+	if( m_AdaptedColormaps.size() >= 256 ) {
+		m_AdaptedColormaps.clear();
+	}
+
+	return m_AdaptedColormaps[parameters] = computeAdaptedColormap( parameters );
+}
+
 void Color::adaptColorMapToImage( ImageHolder *image, bool split )
 {
-	LOG_IF( image->colorMap.size() != 256, Runtime, error ) << "The colormap is of size "
-			<< image->colorMap.size() << " but has to be of size " << 256 << "!";
+	image->colorMap = getAdaptedColormap( getColormapParameters( image, split ) );
+}
+
+void Color::computeWindowLUT( const ColormapParameters &parameters, uint8_t *lut, const size_t &size )
+{
+	//the mapping of computeAdaptedColormap, evaluated at the fractional 8 bit value of every entry
+	const double norm = 256.0 / parameters.extent;
+	const double normMid = static_cast<unsigned short>( norm * fabs( parameters.min ) ) + parameters.offset * norm;
+	const double step = 256.0 / size;
+	const size_t zeroEntries = size / 256;
+
+	for( size_t i = 0; i < size; i++ ) {
+		const double value = normMid + ( i * step - normMid ) * parameters.scaling;
+		//index 0 of the colormap is transparent, it is only used for the values that would be 0 in 8 bit
+		lut[i] = static_cast<uint8_t>( value < 1 ? 1 : value > 255 ? 255 : value );
+	}
+
+	std::fill( lut, lut + zeroEntries, 0 );
+}
+
+Color::ColormapType Color::computeAdaptedColormap( const ColormapParameters &parameters ) const
+{
 	ColormapType retMap ;
 	retMap.resize( 256 );
-	ColormapType tmpMap = util::Singletons::get<Color, 10>().getColormapMap().at( image->lut );
-	const double extent = image->extent;
-	const double min = image->minMax.first->as<double>();
-	const double max = image->minMax.second->as<double>();
-	const double lowerThreshold = image->lowerThreshold;
-	const double upperThreshold = image->upperThreshold;
-	const double offset = image->offset;
-	const double scaling = image->scaling;
+	const ColormapMapType::const_iterator lutIter = m_ColormapMap.find( parameters.lut );
+	LOG_IF( lutIter == m_ColormapMap.end(), Runtime, error ) << "There is no colormap " << parameters.lut << "!";
+	const ColormapType tmpMap = lutIter != m_ColormapMap.end() ? lutIter->second : getFallbackColormap();
+	const double extent = parameters.extent;
+	const double min = parameters.min;
+	const double max = parameters.max;
+	const double lowerThreshold = parameters.lowerThreshold;
+	const double upperThreshold = parameters.upperThreshold;
+	const double offset = parameters.offset;
+	const double scaling = parameters.scaling;
+	const bool split = parameters.split;
 	const double norm = 256.0 / extent;
 	const unsigned short mid = norm * fabs( min );
 	unsigned short scaledVal;
 	const float normMid = mid + (offset * norm );
 	for ( unsigned short i = 0; i < 256; i++ ) {
-		if( i > normMid ) {
-			scaledVal = normMid + ( i - normMid ) * scaling > 255 ? 255 : normMid + ( i - normMid ) * scaling;
+		//images that keep their values internally are stretched to the full range here
+		const double index = std::min<double>( 255, std::max<double>( 0, i * parameters.indexScaling + parameters.indexOffset ) );
+
+		if( index > normMid ) {
+			scaledVal = normMid + ( index - normMid ) * scaling > 255 ? 255 : normMid + ( index - normMid ) * scaling;
 		} else {
-			scaledVal = normMid - ( normMid * scaling ) + i * scaling < 0 ? 0 : normMid - ( normMid * scaling ) + i * scaling;
+			scaledVal = normMid - ( normMid * scaling ) + index * scaling < 0 ? 0 : normMid - ( normMid * scaling ) + index * scaling;
 		}
 		retMap[i] = tmpMap[scaledVal];
 	}
@@ -228,7 +320,7 @@ void Color::adaptColorMapToImage( ImageHolder *image, bool split )
 	ColormapType posVec( 256 - mid );
 
 	//only stuff necessary for colormaps
-	if( image->imageType == ImageHolder::z_map ) {
+	if( parameters.zmap ) {
 
 		if( split ) {
 			assert( negVec.size() + posVec.size() == 256 );
@@ -257,7 +349,7 @@ void Color::adaptColorMapToImage( ImageHolder *image, bool split )
 		}
 	}
 
-	if( image->imageType == ImageHolder::z_map ) {
+	if( parameters.zmap ) {
 		ColormapType zmapLUT;
 		zmapLUT.resize( 256 );
 
@@ -267,10 +359,10 @@ void Color::adaptColorMapToImage( ImageHolder *image, bool split )
 
 		//kill the zero value
 		zmapLUT[0] = QColor( 0, 0, 0, 0 ).rgba();
-		image->colorMap = zmapLUT;
+		return zmapLUT;
 	} else {
 		retMap[0] = QColor( 0, 0, 0, 0 ).rgba();
-		image->colorMap = retMap;
+		return retMap;
 	}
 
 }
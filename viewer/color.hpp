@@ -33,6 +33,7 @@
 #include <QVector>
 #include <QIcon>
 #include <QRgb>
+#include <QMutex>
 #include <boost/regex.h>
 
 namespace isis
@@ -45,6 +46,27 @@ class ImageHolder;
 namespace color
 {
 
+///everything the colormap of an image depends on
+struct ColormapParameters {
+	ColormapParameters();
+	std::string lut;
+	double min;
+	double max;
+	double extent;
+	double scaling;
+	double offset;
+	double lowerThreshold;
+	double upperThreshold;
+	///maps the internal values to the range 0..255, see ImageHolder::getColormapIndexScaling
+	double indexScaling;
+	double indexOffset;
+	bool zmap;
+	bool split;
+
+	bool operator==( const ColormapParameters &other ) const;
+	bool operator!=( const ColormapParameters &other ) const { return !operator==( other ); }
+	bool operator<( const ColormapParameters &other ) const;
+};
 
 class Color
 {
@@ -56,7 +78,7 @@ public:
 	bool addColormap( const std::string &path, const boost::regex &separator
 					  = boost::regex( "[[:space:]]+" ) );
 
-	ColormapMapType getColormapMap() const { return m_ColormapMap; }
+	const ColormapMapType &getColormapMap() const { return m_ColormapMap; }
 	void initStandardColormaps();
 
 	QIcon getIcon( const std::string &lutName, size_t w, size_t h, icon_type = both, bool flipped = false ) const;
@@ -64,12 +86,26 @@ public:
 	bool hasColormap( const std::string &name ) const;
 	ColormapType getFallbackColormap() const;
 
+	static ColormapParameters getColormapParameters( const ImageHolder *image, bool split = true );
+	/**
+	 * Returns the colormap adapted to the given parameters.
+	 * The adapted colormaps are cached, so images with the same parameters share one colormap and it is only computed once.
+	 */
+	ColormapType getAdaptedColormap( const ColormapParameters &parameters );
 	void adaptColorMapToImage( ImageHolder *image, bool split = true );
-
-
+	/**
+	 * Computes the LUT that maps the values of an image with high precision to the index of the colormap.
+	 * It applies scaling and offset of the parameters the same way getAdaptedColormap does for 8 bit images.
+	 */
+	static void computeWindowLUT( const ColormapParameters &parameters, uint8_t *lut, const size_t &size );
 
 private:
 	ColormapMapType m_ColormapMap;
+	std::map<ColormapParameters, ColormapType> m_AdaptedColormaps;
+	///images are loaded on worker threads, so the colormaps are adapted concurrently to the GUI
+	QMutex m_AdaptedColormapsMutex;
+
+	ColormapType computeAdaptedColormap( const ColormapParameters &parameters ) const;
 };
 
 }
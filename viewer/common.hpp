@@ -48,6 +48,8 @@ namespace viewer
 {
 class ImageHolder;
 typedef uint8_t InternalImageType;
+///internal type of images with high precision, see ImageHolder::setHighPrecision
+typedef uint16_t InternalImageHighPrecisionType;
 typedef isis::util::color24 InternalImageColorType;
 
 enum PlaneOrientation { axial, sagittal, coronal };
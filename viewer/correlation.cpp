@@ -0,0 +1,177 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * correlation.cpp
+ *
+ * Description: seed based correlation of time series
+ *
+ ******************************************************************/
+#include "correlation.hpp"
+#include <cmath>
+#include <boost/foreach.hpp>
+
+namespace isis
+{
+namespace viewer
+{
+namespace operation
+{
+
+void Correlation::createTimeSeries( const data::Image &image, float *dest )
+{
+	const util::FixedVector<size_t, 4> size = image.getSizeAsVector();
+	const size_t stride = getStride( size[3] );
+
+	//every row of every volume is scattered into the series of its voxels
+	#pragma omp parallel for
+
+	for( int32_t z = 0; z < static_cast<int32_t>( size[2] ); z++ ) {
+		for( size_t y = 0; y < size[1]; y++ ) {
+			float *rowSeries = dest + ( z * size[1] + y ) * size[0] * stride;
+
+			for( size_t t = 0; t < size[3]; t++ ) {
+				const data::Chunk chunk = image.getChunk( 0, y, z, t, false );
+				const util::FixedVector<size_t, 4> chunkSize = chunk.getSizeAsVector();
+				const size_t cy = y % chunkSize[1], cz = z % chunkSize[2], ct = t % chunkSize[3];
+
+				switch( chunk.getTypeID() ) {
+				case data::ValuePtr<bool>::staticID:
+					transposeRow<bool>( &chunk.voxel<bool>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				case data::ValuePtr<int8_t>::staticID:
+					transposeRow<int8_t>( &chunk.voxel<int8_t>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				case data::ValuePtr<uint8_t>::staticID:
+					transposeRow<uint8_t>( &chunk.voxel<uint8_t>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				case data::ValuePtr<int16_t>::staticID:
+					transposeRow<int16_t>( &chunk.voxel<int16_t>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				case data::ValuePtr<uint16_t>::staticID:
+					transposeRow<uint16_t>( &chunk.voxel<uint16_t>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				case data::ValuePtr<int32_t>::staticID:
+					transposeRow<int32_t>( &chunk.voxel<int32_t>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				case data::ValuePtr<uint32_t>::staticID:
+					transposeRow<uint32_t>( &chunk.voxel<uint32_t>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				case data::ValuePtr<int64_t>::staticID:
+					transposeRow<int64_t>( &chunk.voxel<int64_t>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				case data::ValuePtr<uint64_t>::staticID:
+					transposeRow<uint64_t>( &chunk.voxel<uint64_t>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				case data::ValuePtr<float>::staticID:
+					transposeRow<float>( &chunk.voxel<float>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				case data::ValuePtr<double>::staticID:
+					transposeRow<double>( &chunk.voxel<double>( 0, cy, cz, ct ), rowSeries + t, size[0], stride );
+					break;
+				default:
+					LOG( Runtime, error ) << "Can not create time series of data of type " << chunk.getTypeName() << "!";
+					break;
+				}
+			}
+		}
+	}
+}
+
+Correlation::Correlation( const float *series, const util::FixedVector<size_t, 4> &size )
+	: m_Series( series ),
+	  m_Size( size ),
+	  m_Stride( getStride( size[3] ) ),
+	  m_Volume( size[0] * size[1] * size[2] ),
+	  m_InverseNorms( m_Volume ),
+	  m_SeedBuffer( m_Stride + 8, 0 )
+{
+	m_Seed = reinterpret_cast<float *>( ( reinterpret_cast<uintptr_t>( &m_SeedBuffer[0] ) + 31 ) & ~static_cast<uintptr_t>( 31 ) );
+
+	#pragma omp parallel for
+
+	for( int64_t voxel = 0; voxel < static_cast<int64_t>( m_Volume ); voxel++ ) {
+		const float *voxelSeries = m_Series + voxel * m_Stride;
+		double sum = 0;
+		double sumOfSquares = 0;
+
+		for( size_t t = 0; t < m_Size[3]; t++ ) {
+			sum += voxelSeries[t];
+		}
+
+		const double mean = sum / m_Size[3];
+
+		for( size_t t = 0; t < m_Size[3]; t++ ) {
+			sumOfSquares += ( voxelSeries[t] - mean ) * ( voxelSeries[t] - mean );
+		}
+
+		//constant series do not correlate with anything
+		m_InverseNorms[voxel] = sumOfSquares > 0 ? 1.0 / std::sqrt( sumOfSquares ) : 0;
+	}
+}
+
+void Correlation::setSeed( const size_t &voxel )
+{
+	std::copy( m_Series + voxel * m_Stride, m_Series + voxel * m_Stride + m_Size[3], m_Seed );
+	normalizeSeed();
+}
+
+void Correlation::setSeed( const std::vector<size_t> &voxels )
+{
+	std::vector<double> sum( m_Size[3], 0 );
+	BOOST_FOREACH( std::vector<size_t>::const_reference voxel, voxels ) {
+		const float *voxelSeries = m_Series + voxel * m_Stride;
+
+		for( size_t t = 0; t < m_Size[3]; t++ ) {
+			sum[t] += voxelSeries[t];
+		}
+	}
+
+	for( size_t t = 0; t < m_Size[3]; t++ ) {
+		m_Seed[t] = voxels.empty() ? 0 : sum[t] / voxels.size();
+	}
+
+	normalizeSeed();
+}
+
+void Correlation::normalizeSeed()
+{
+	double sum = 0;
+	double sumOfSquares = 0;
+
+	for( size_t t = 0; t < m_Size[3]; t++ ) {
+		sum += m_Seed[t];
+	}
+
+	const double mean = sum / m_Size[3];
+
+	for( size_t t = 0; t < m_Size[3]; t++ ) {
+		sumOfSquares += ( m_Seed[t] - mean ) * ( m_Seed[t] - mean );
+	}
+
+	const double inverseNorm = sumOfSquares > 0 ? 1.0 / std::sqrt( sumOfSquares ) : 0;
+
+	for( size_t t = 0; t < m_Size[3]; t++ ) {
+		m_Seed[t] = ( m_Seed[t] - mean ) * inverseNorm;
+	}
+}
+
+}
+}
+}
@@ -0,0 +1,132 @@
+/****************************************************************
+ *
+ * <Copyright information>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * Author: Erik Türke, tuerke@cbs.mpg.de
+ *
+ * correlation.hpp
+ *
+ * Description: seed based correlation of time series
+ *
+ ******************************************************************/
+#ifndef VAST_CORRELATION_HPP
+#define VAST_CORRELATION_HPP
+
+#include "common.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace isis
+{
+namespace viewer
+{
+namespace operation
+{
+
+/**
+ * Pearson correlation of the voxel time series of a 4D image with a seed time series.
+ * It works on the time-contiguous layout created by createTimeSeries: all timesteps of a voxel are next to each other,
+ * every series is padded with zeros to getStride() floats and starts 32 byte aligned.
+ * This class does not depend on Qt, so it can be used without the GUI.
+ */
+class Correlation : boost::noncopyable
+{
+public:
+	static size_t getStride( const size_t &timesteps ) { return ( timesteps + 7 ) / 8 * 8; }
+	/**
+	 * Transposes the 4D image into the time-contiguous layout.
+	 * dest has to hold size[0] * size[1] * size[2] * getStride( size[3] ) floats and has to be zero initialized.
+	 */
+	static void createTimeSeries( const data::Image &image, float *dest );
+
+	/**
+	 * Computes the length of every demeaned series. The series have to stay valid as long as this object is used.
+	 */
+	Correlation( const float *series, const util::FixedVector<size_t, 4> &size );
+
+	///uses the series of the voxel with the given linear index as seed
+	void setSeed( const size_t &voxel );
+	///uses the mean series of the voxels with the given linear indices as seed
+	void setSeed( const std::vector<size_t> &voxels );
+
+	///correlation of the voxel with the given linear index with the seed
+	float correlate( const size_t &voxel ) const {
+		return dotProduct( m_Seed, m_Series + voxel * m_Stride, m_Stride ) * m_InverseNorms[voxel];
+	}
+
+	/**
+	 * Computes the correlation of every voxel with the seed. dest has to hold one value per voxel.
+	 * This is a product of the series matrix and the seed. It is computed in parallel on blocks of voxels, so the seed stays in the cache.
+	 */
+	template<typename TYPE>
+	void computeMap( TYPE *dest ) const {
+		const int64_t blockSize = 256;
+		const int64_t numberOfBlocks = ( m_Volume + blockSize - 1 ) / blockSize;
+		#pragma omp parallel for schedule( dynamic )
+
+		for( int64_t block = 0; block < numberOfBlocks; block++ ) {
+			const size_t end = std::min<size_t>( ( block + 1 ) * blockSize, m_Volume );
+
+			for( size_t voxel = block * blockSize; voxel < end; voxel++ ) {
+				dest[voxel] = correlate( voxel );
+			}
+		}
+	}
+
+	size_t getVolume() const { return m_Volume; }
+
+private:
+	const float *m_Series;
+	const util::FixedVector<size_t, 4> m_Size;
+	const size_t m_Stride;
+	const size_t m_Volume;
+	///inverse length of every demeaned series, 0 for constant series
+	std::vector<float> m_InverseNorms;
+	std::vector<float> m_SeedBuffer;
+	///demeaned seed of unit length. As it sums up to zero, the other series do not have to be demeaned for the dot product.
+	float *m_Seed;
+
+	static float dotProduct( const float *x, const float *y, const size_t &length ) {
+		//eight independent sums, so the loop is vectorized without reordering a single sum
+		float sums[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+		for( size_t t = 0; t < length; t += 8 ) {
+			for( size_t i = 0; i < 8; i++ ) {
+				sums[i] += x[t + i] * y[t + i];
+			}
+		}
+
+		return ( ( sums[0] + sums[1] ) + ( sums[2] + sums[3] ) ) + ( ( sums[4] + sums[5] ) + ( sums[6] + sums[7] ) );
+	}
+
+	void normalizeSeed();
+
+	template<typename TYPE>
+	static void transposeRow( const TYPE *src, float *dest, const size_t &length, const size_t &stride ) {
+		for( size_t x = 0; x < length; x++ ) {
+			dest[x * stride] = static_cast<float>( src[x] );
+		}
+	}
+};
+
+}
+}
+}
+
+#endif
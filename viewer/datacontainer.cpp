@@ -32,7 +32,14 @@ namespace isis
 namespace viewer
 {
 
-boost::shared_ptr<ImageHolder> DataContainer::addImage( const data::Image &image, const ImageHolder::ImageType &imageType )
+boost::shared_ptr<ImageHolder> DataContainer::addImage( const data::Image &image, const ImageHolder::ImageType &imageType, const size_t &maxResidentVolumes, bool highPrecision )
+{
+	boost::shared_ptr<ImageHolder> tmpHolder = createImageHolder( image, imageType, maxResidentVolumes, highPrecision );
+	insertImageHolder( tmpHolder );
+	return tmpHolder;
+}
+
+boost::shared_ptr<ImageHolder> DataContainer::createImageHolder( const data::Image &image, const ImageHolder::ImageType &imageType, const size_t &maxResidentVolumes, bool highPrecision, bool parallel )
 {
 	std::string fileName;
 
@@ -43,6 +50,17 @@ boost::shared_ptr<ImageHolder> DataContainer::addImage( const data::Image &image
 		fileName = path.branch_path().string();
 	}
 
+	boost::shared_ptr<ImageHolder>  tmpHolder = boost::shared_ptr<ImageHolder> ( new ImageHolder ) ;
+	tmpHolder->setMaxResidentVolumes( maxResidentVolumes );
+	//4D images stay at 8 bit, they would need twice the memory
+	tmpHolder->setHighPrecision( highPrecision && imageType == ImageHolder::structural_image && image.getSizeAsVector()[3] == 1 );
+	tmpHolder->setImage( image, imageType, fileName, parallel );
+	return tmpHolder;
+}
+
+void DataContainer::insertImageHolder( boost::shared_ptr<ImageHolder> imageHolder )
+{
+	const std::string fileName = imageHolder->getFileNames().front();
 	std::string newFileName = fileName;
 
 	if( find( fileName ) != end() ) {
@@ -53,13 +71,12 @@ boost::shared_ptr<ImageHolder> DataContainer::addImage( const data::Image &image
 			ss << fileName << " (" << ++index << ")";
 			newFileName = ss.str();
 		}
+
+		imageHolder->setFileName( newFileName );
 	}
 
-	boost::shared_ptr<ImageHolder>  tmpHolder = boost::shared_ptr<ImageHolder> ( new ImageHolder ) ;
-	tmpHolder->setImage( image, imageType, newFileName );
-	tmpHolder->setID( size()  );
-	insert( std::make_pair<std::string, boost::shared_ptr<ImageHolder> >( newFileName, tmpHolder ) );
-	return tmpHolder;
+	imageHolder->setID( size()  );
+	insert( std::make_pair<std::string, boost::shared_ptr<ImageHolder> >( newFileName, imageHolder ) );
 }
 
 boost::shared_ptr< ImageHolder > DataContainer::getImageByID( short unsigned int id ) const
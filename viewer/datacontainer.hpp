@@ -44,15 +44,27 @@ namespace viewer
 class DataContainer : public std::map<std::string, boost::shared_ptr<ImageHolder> >
 {
 public:
-	///simply adds an isis image to the vector
-	boost::shared_ptr<ImageHolder> addImage( const data::Image &image, const ImageHolder::ImageType &imageType );
+	/**
+	 * Simply adds an isis image to the vector. At most maxResidentVolumes volumes of the image are kept in the internal data type (0 means no limit).
+	 * If highPrecision is true, 3D structural images are held with 16 bit (see ImageHolder::setHighPrecision).
+	 */
+	boost::shared_ptr<ImageHolder> addImage( const data::Image &image, const ImageHolder::ImageType &imageType, const size_t &maxResidentVolumes = 0, bool highPrecision = false );
+
+	/**
+	 * Creates the image holder for an isis image without adding it to the container.
+	 * This does not touch the container, so it can be called from a worker thread.
+	 * If parallel is false the first volume is converted by the calling thread only.
+	 */
+	static boost::shared_ptr<ImageHolder> createImageHolder( const data::Image &image, const ImageHolder::ImageType &imageType, const size_t &maxResidentVolumes = 0, bool highPrecision = false, bool parallel = true );
+	///adds an image holder created by createImageHolder. If its file name is already taken it is renamed.
+	void insertImageHolder( boost::shared_ptr<ImageHolder> imageHolder );
 
 	boost::shared_ptr<ImageHolder> getImageByID( unsigned short id ) const;
 
 	///returns a boost::weak_ptr of the images data. Actually this also is a convinient function.
 	boost::weak_ptr<void>
 	getImageWeakPointer( const boost::shared_ptr<ImageHolder> image, size_t timestep = 0 ) const {
-		return image->getImageVector()[timestep]->getRawAddress();
+		return image->getImageWeakPointer( timestep );
 	}
 
 
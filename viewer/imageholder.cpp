@@ -28,6 +28,12 @@
 #include "imageholder.hpp"
 #include "common.hpp"
 #include <numeric>
+#include <algorithm>
+#include <QtConcurrentRun>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace isis
 {
@@ -36,7 +42,24 @@ namespace viewer
 
 ImageHolder::ImageHolder()
 	: m_ZeroIsReserved( true ),
-	  m_ReservedValue( 0 )
+	  m_ReservedValue( 0 ),
+	  m_DataRevision( 0 ),
+	  m_FullChangeRevision( 0 ),
+	  m_ColorMapRevision( 0 ),
+	  m_OrientationRevision( 0 ),
+	  m_ReserveZero( false ),
+	  m_MaxResidentVolumes( 0 ),
+	  m_HighPrecision( false ),
+	  m_WindowLUTRevision( 0 ),
+	  m_ScalingToInternal( 1 ),
+	  m_OffsetToInternal( 0 ),
+	  m_ColormapIndexScaling( 1 ),
+	  m_ColormapIndexOffset( 0 ),
+	  m_ConversionGeneration( 0 ),
+	  m_AccessCounter( 0 ),
+	  m_ResidentCount( 0 ),
+	  m_TimeSeries( 0 ),
+	  m_TimeSeriesPending( false )
 {}
 
 boost::numeric::ublas::matrix< double > ImageHolder::getNormalizedImageOrientation( bool transposed ) const
@@ -126,7 +149,7 @@ boost::numeric::ublas::matrix< double > ImageHolder::getImageOrientation( bool t
 	return retMatrix;
 }
 
-bool ImageHolder::setImage( const data::Image &image, const ImageType &_imageType, const std::string &filename )
+bool ImageHolder::setImage( const data::Image &image, const ImageType &_imageType, const std::string &filename, bool parallel )
 {
 	LOG( Dev, info ) << "setImage of " << filename;
 	//some checks
@@ -165,70 +188,35 @@ bool ImageHolder::setImage( const data::Image &image, const ImageType &_imageTyp
 	m_ImageSize = image.getSizeAsVector();
 	LOG( Dev, verbose_info )  << "Fetched image of size " << m_ImageSize << " and type "
 								<< image.getMajorTypeName() << ".";
-	//copy the image into continuous memory space and assure consistent data type
+	//color images are copied at once. All other images are converted to the internal type volume by volume when they are needed
 	isRGB = !(data::ValuePtr<util::color24>::staticID != majorTypeID && data::ValuePtr<util::color48>::staticID != majorTypeID);
-    const bool reserveZero = m_ZeroIsReserved && !isRGB && imageType == z_map;
+	m_ReserveZero = m_ZeroIsReserved && !isRGB && imageType == z_map;
+	LOG_IF( m_HighPrecision && ( isRGB || imageType != structural_image ), Runtime, warning ) << "High precision is only supported for structural images, "
+			<< m_Filenames.front() << " is shown with 8 bit.";
+	m_HighPrecision = m_HighPrecision && !isRGB && imageType == structural_image;
+	m_LastAccess.resize( m_ImageSize[3], 0 );
+
 	if( !isRGB ) {
 		minMax = image.getMinMax();
-		copyImageToVector<InternalImageType>( image, reserveZero );
+		initInternalScaling();
+		m_ChunkVector.resize( m_ImageSize[3] );
+		m_Histograms.resize( m_ImageSize[3], std::vector<double>( std::numeric_limits<InternalImageType>::max() + 1 ) );
+		m_HistogramRevisions.resize( m_ImageSize[3], std::numeric_limits<size_t>::max() );
+
+		//the first volume is needed anyway
+		loadVolume( 0, parallel );
 	} else {
-		copyImageToVector<InternalImageColorType>( image, reserveZero );
+		copyImageToVector<InternalImageColorType>( image, m_ReserveZero );
 	}
-	
-	
-	LOG_IF( m_ImageVector.empty(), Dev, error ) << "Size of image vector is 0!";
 
-	if( m_ImageVector.size() != m_ImageSize[3] ) {
+	LOG_IF( m_ChunkVector.empty(), Dev, error ) << "Size of chunk vector is 0!";
+
+	if( m_ChunkVector.size() != m_ImageSize[3] ) {
 		LOG( Dev, error ) << "The number of timesteps (" << m_ImageSize[3]
-							  << ") does not coincide with the number of volumes ("  << m_ImageVector.size() << ").";
+							  << ") does not coincide with the number of volumes ("  << m_ChunkVector.size() << ").";
 		return false;
 	}
 
-	//create the chunk vector
-	BOOST_FOREACH( std::vector< ImagePointerType >::const_reference pointerRef, m_ImageVector ) {
-		m_ChunkVector.push_back( data::Chunk(  pointerRef, m_ImageSize[0], m_ImageSize[1], m_ImageSize[2] ) );
-	}
-
-	// if m_ZeroIsReserved is set we reserve a value (m_ReservedValue) in the internal image that indicates the true zero value in the origin image
-	if( reserveZero ) {
-		switch ( majorTypeID ) {
-		case data::ValuePtr<bool>::staticID:
-			_setTrueZero<bool>( image );
-			break;
-		case data::ValuePtr<int8_t>::staticID:
-			_setTrueZero<int8_t>( image );
-			break;
-		case data::ValuePtr<uint8_t>::staticID:
-			_setTrueZero<uint8_t>( image );
-			break;
-		case data::ValuePtr<int16_t>::staticID:
-			_setTrueZero<int16_t>( image );
-			break;
-		case data::ValuePtr<uint16_t>::staticID:
-			_setTrueZero<uint16_t>( image );
-			break;
-		case data::ValuePtr<int32_t>::staticID:
-			_setTrueZero<int32_t>( image );
-			break;
-		case data::ValuePtr<uint32_t>::staticID:
-			_setTrueZero<uint32_t>( image );
-			break;
-		case data::ValuePtr<int64_t>::staticID:
-			_setTrueZero<int64_t>( image );
-			break;
-		case data::ValuePtr<uint64_t>::staticID:
-			_setTrueZero<uint64_t>( image );
-			break;
-		case data::ValuePtr<float>::staticID:
-			_setTrueZero<float>( image );
-			break;
-		case data::ValuePtr<double>::staticID:
-			_setTrueZero<double>( image );
-			break;
-		}
-	}
-	LOG( Dev, verbose_info ) << "Spliced image to " << m_ImageVector.size() << " volumes.";
-
 	//image seems to be ok...i guess
 
 
@@ -263,7 +251,6 @@ bool ImageHolder::setImage( const data::Image &image, const ImageType &_imageTyp
 
 	if( !isRGB ) {
 		extent = fabs( minMax.second->as<double>() - minMax.first->as<double>() );
-        updateHistogram();
 		m_PropMap.setPropertyAs<double>( "scalingMinValue", minMax.first->as<double>() );
 		m_PropMap.setPropertyAs<double>( "scalingMaxValue", minMax.second->as<double>() );
 	}
@@ -302,36 +289,520 @@ bool ImageHolder::removeChangedAttribute( const std::string &attribute )
 	}
 }
 
-void ImageHolder::updateHistogram()
+void ImageHolder::initInternalScaling()
 {
-	const size_t volume = getImageSize()[0] * getImageSize()[1] * getImageSize()[2];
-	const double extent = getInternalExtent();
+	const double min = minMax.first->as<double>(), max = minMax.second->as<double>();
 
-	boost::scoped_array<double> nHistogram ( new double[( size_t )extent + 1] );
+	if( m_HighPrecision ) {
+		setScalingToInternalType<InternalImageHighPrecisionType>( *m_Image, false );
+		m_ScalingToInternal = scalingToInternalType.first->as<double>();
+		m_OffsetToInternal = scalingToInternalType.second->as<double>();
+		InternalImageHighPrecisionType internMin, internMax;
+		convertRow<double>( &min, &internMin, 1, m_ScalingToInternal, m_OffsetToInternal, false, m_ReservedValue );
+		convertRow<double>( &max, &internMax, 1, m_ScalingToInternal, m_OffsetToInternal, false, m_ReservedValue );
+		internMinMax.first = util::Value<InternalImageHighPrecisionType>( internMin );
+		internMinMax.second = util::Value<InternalImageHighPrecisionType>( internMax );
+	} else {
+		setScalingToInternalType<InternalImageType>( *m_Image, m_ReserveZero );
+		m_ScalingToInternal = scalingToInternalType.first->as<double>();
+		m_OffsetToInternal = scalingToInternalType.second->as<double>();
+		InternalImageType internMin, internMax;
+		convertRow<double>( &min, &internMin, 1, m_ScalingToInternal, m_OffsetToInternal, false, m_ReservedValue );
+		convertRow<double>( &max, &internMax, 1, m_ScalingToInternal, m_OffsetToInternal, false, m_ReservedValue );
+		internMinMax.first = util::Value<InternalImageType>( internMin );
+		internMinMax.second = util::Value<InternalImageType>( internMax );
+	}
+}
 
-	histogramVector.resize( getImageSize()[3] );
-	histogramVectorWOZero.resize( getImageSize()[3] );
+void ImageHolder::setHighPrecision( bool highPrecision )
+{
+	//before setImage only the wish is stored, it is checked by setImage
+	if( !m_Image ) {
+		m_HighPrecision = highPrecision;
+		return;
+	}
 
-	for( unsigned short t = 0; t < getImageSize()[3]; t++ ) {
-		histogramVector[t] = ( double * ) calloc( extent + 1, sizeof( double ) ) ;
-		histogramVectorWOZero[t] = ( double * ) calloc( extent, sizeof( double ) );
-		const InternalImageType *dataPtr = static_cast<InternalImageType *>( getImageVector()[t]->getRawAddress().get() );
+	if( highPrecision && ( isRGB || imageType != structural_image ) ) {
+		LOG( Runtime, warning ) << "High precision is only supported for structural images, " << getFileNames().front() << " is shown with 8 bit.";
+		return;
+	}
+
+	if( highPrecision == m_HighPrecision ) {
+		return;
+	}
+
+	{
+		QMutexLocker locker( &m_VolumeMutex );
+		m_HighPrecision = highPrecision;
+		initInternalScaling();
+		//the volumes are converted again with the new type when they are requested
+		std::fill( m_ChunkVector.begin(), m_ChunkVector.end(), boost::shared_ptr<data::Chunk>() );
+		m_ResidentCount = 0;
+		m_ConversionGeneration++;
+		m_WindowLUT.reset();
+	}
+	LOG( Dev, info ) << getFileNames().front() << " uses " << ( m_HighPrecision ? 16 : 8 ) << " bit internally";
+	m_ColormapParameters = color::ColormapParameters();
+	updateColorMap();
+	voxelDataChanged();
+}
+
+void ImageHolder::setInternalScaling( const double &scaling, const double &offset )
+{
+	{
+		QMutexLocker locker( &m_VolumeMutex );
+		scalingToInternalType.first = util::Value<double>( scaling );
+		scalingToInternalType.second = util::Value<double>( offset );
+		m_ScalingToInternal = scaling;
+		m_OffsetToInternal = offset;
+		m_ColormapIndexScaling = 1;
+		m_ColormapIndexOffset = 0;
+		std::fill( m_ChunkVector.begin(), m_ChunkVector.end(), boost::shared_ptr<data::Chunk>() );
+		m_ResidentCount = 0;
+		m_ConversionGeneration++;
+	}
+	voxelDataChanged();
+}
+
+boost::shared_ptr<const ImageHolder::WindowLUTType> ImageHolder::getWindowLUT() const
+{
+	QMutexLocker locker( &m_VolumeMutex );
+	return m_WindowLUT;
+}
+
+data::Chunk ImageHolder::getVolume( const size_t &timestep, bool parallel )
+{
+	{
+		QMutexLocker locker( &m_VolumeMutex );
+
+		if( m_ChunkVector[timestep] ) {
+			m_LastAccess[timestep] = ++m_AccessCounter;
+			return *m_ChunkVector[timestep];
+		}
+	}
+	return loadVolume( timestep, parallel );
+}
+
+bool ImageHolder::isVolumeResident( const size_t &timestep ) const
+{
+	QMutexLocker locker( &m_VolumeMutex );
+	return m_ChunkVector[timestep].get();
+}
+
+ImageHolder::ConversionParameters ImageHolder::getConversionParameters() const
+{
+	QMutexLocker locker( &m_VolumeMutex );
+	const ConversionParameters parameters = { m_ScalingToInternal, m_OffsetToInternal, m_HighPrecision, m_ConversionGeneration };
+	return parameters;
+}
+
+boost::shared_ptr<data::Chunk> ImageHolder::shareVolume( const size_t &timestep, const unsigned short &typeID, const ConversionParameters &parameters ) const
+{
+	//color images are not scaled, so their scaling stays 1
+	if( m_ReserveZero || parameters.scaling != 1 || parameters.offset != 0 ) {
+		return boost::shared_ptr<data::Chunk>();
+	}
+
+	const data::Chunk chunk = m_Image->getChunk( 0, 0, 0, timestep, false );
+	const util::FixedVector<size_t, 4> chunkSize = chunk.getSizeAsVector();
+
+	if( chunk.getTypeID() != typeID || chunkSize[0] != m_ImageSize[0] || chunkSize[1] != m_ImageSize[1] || chunkSize[2] != m_ImageSize[2] ) {
+		return boost::shared_ptr<data::Chunk>();
+	}
+
+	LOG( Dev, verbose_info ) << "Sharing volume " << timestep << " of " << getFileNames().front() << " with the source image";
+
+	if( chunkSize[3] == 1 ) {
+		return boost::shared_ptr<data::Chunk>( new data::Chunk( chunk ) );
+	}
+
+	//the chunk holds several timesteps, the volume is a reference into its memory
+	const std::vector<ImagePointerType> volumes = chunk.asValuePtrBase().splice( m_ImageSize[0] * m_ImageSize[1] * m_ImageSize[2] );
+	return boost::shared_ptr<data::Chunk>( new data::Chunk( volumes[timestep % chunkSize[3]], m_ImageSize[0], m_ImageSize[1], m_ImageSize[2] ) );
+}
+
+template<typename DEST>
+boost::shared_ptr<data::Chunk> ImageHolder::createVolume( const size_t &timestep, const ConversionParameters &parameters, bool parallel ) const
+{
+	const size_t volume = m_ImageSize[0] * m_ImageSize[1] * m_ImageSize[2];
+	data::ValuePtr<DEST> volumePtr( ( DEST * ) malloc( volume * sizeof( DEST ) ), volume );
+	convertVolume( timestep, &volumePtr[0], parameters, parallel );
+	return boost::shared_ptr<data::Chunk>( new data::Chunk( volumePtr, m_ImageSize[0], m_ImageSize[1], m_ImageSize[2] ) );
+}
+
+data::Chunk ImageHolder::loadVolume( const size_t &timestep, bool parallel )
+{
+	//the conversion is done without holding the lock, so several volumes can be converted at the same time
+	const ConversionParameters parameters = getConversionParameters();
+	boost::shared_ptr<data::Chunk> chunk = shareVolume( timestep, parameters.highPrecision ? data::ValuePtr<InternalImageHighPrecisionType>::staticID : data::ValuePtr<InternalImageType>::staticID, parameters );
+
+	if( !chunk ) {
+		chunk = parameters.highPrecision ? createVolume<InternalImageHighPrecisionType>( timestep, parameters, parallel ) : createVolume<InternalImageType>( timestep, parameters, parallel );
+	}
+
+	QMutexLocker locker( &m_VolumeMutex );
+	m_LastAccess[timestep] = ++m_AccessCounter;
+
+	//the precision or the scaling may have been changed meanwhile, such a volume is not kept
+	if( parameters.generation != m_ConversionGeneration ) {
+		return *chunk;
+	}
+
+	//another thread may have converted this volume meanwhile
+	if( !m_ChunkVector[timestep] ) {
+		m_ChunkVector[timestep] = chunk;
+		m_ResidentCount++;
+		evictVolumes();
+		LOG( Dev, verbose_info ) << "Converted volume " << timestep << " of " << getFileNames().front();
+	}
 
-		//create the histogram
-		//      #pragma omp parallel for
-		for( size_t i = 0; i < volume; i++ ) {
-			histogramVector[t][dataPtr[i]]++;
+	return *m_ChunkVector[timestep];
+}
+
+void ImageHolder::evictVolumes()
+{
+	while( m_MaxResidentVolumes && m_ResidentCount > m_MaxResidentVolumes ) {
+		size_t leastRecentlyUsed = 0;
+		size_t minAccess = std::numeric_limits<size_t>::max();
+
+		for( size_t t = 0; t < m_ChunkVector.size(); t++ ) {
+			if( m_ChunkVector[t] && m_LastAccess[t] < minAccess ) {
+				minAccess = m_LastAccess[t];
+				leastRecentlyUsed = t;
+			}
+		}
+
+		m_ChunkVector[leastRecentlyUsed].reset();
+		m_ResidentCount--;
+	}
+}
+
+void ImageHolder::prefetchVolumes( const size_t &timestep, const size_t &count )
+{
+	if( isRGB || m_ImageSize[3] < 2 ) {
+		return;
+	}
+
+	//prefetching more volumes than we may keep would only make them evict each other
+	size_t n = std::min<size_t>( count, m_ImageSize[3] - 1 );
+
+	if( m_MaxResidentVolumes ) {
+		n = std::min<size_t>( n, m_MaxResidentVolumes - 1 );
+	}
+
+	QMutexLocker locker( &m_VolumeMutex );
+
+	for( size_t i = 1; i <= n; i++ ) {
+		const size_t t = ( timestep + i ) % m_ImageSize[3];
+
+		if( !m_ChunkVector[t] && m_PendingVolumes.insert( t ).second ) {
+			QtConcurrent::run( &ImageHolder::prefetchVolume, shared_from_this(), t );
+		}
+	}
+}
+
+void ImageHolder::prefetchVolume( boost::shared_ptr<ImageHolder> image, size_t timestep )
+{
+	//several volumes are prefetched at the same time, so each one is converted by a single thread
+	if( !image->isVolumeResident( timestep ) ) {
+		image->loadVolume( timestep, false );
+	}
+
+	QMutexLocker locker( &image->m_VolumeMutex );
+	image->m_PendingVolumes.erase( timestep );
+}
+
+void ImageHolder::requestTimeSeries()
+{
+	QMutexLocker locker( &m_TimeSeriesMutex );
+
+	if( !isRGB && m_ImageSize[3] > 1 && !m_TimeSeries && !m_TimeSeriesPending ) {
+		m_TimeSeriesPending = true;
+		QtConcurrent::run( &ImageHolder::prefetchTimeSeries, shared_from_this() );
+	}
+}
+
+void ImageHolder::prefetchTimeSeries( boost::shared_ptr<ImageHolder> image )
+{
+	image->buildTimeSeries();
+}
+
+const float *ImageHolder::getTimeSeries( bool wait )
+{
+	if( wait ) {
+		buildTimeSeries();
+		return m_TimeSeries;
+	}
+
+	//if the mutex is locked the series are just being built
+	if( !m_TimeSeriesMutex.tryLock() ) {
+		return 0;
+	}
+
+	const float *ret = m_TimeSeries;
+	m_TimeSeriesMutex.unlock();
+	return ret;
+}
+
+void ImageHolder::buildTimeSeries()
+{
+	QMutexLocker locker( &m_TimeSeriesMutex );
+
+	if( m_TimeSeries || isRGB ) {
+		return;
+	}
+
+	const data::Image &image = *m_Image;
+	const size_t stride = getTimeSeriesStride();
+	m_TimeSeriesBuffer.assign( m_ImageSize[0] * m_ImageSize[1] * m_ImageSize[2] * stride + 8, 0 );
+	LOG( Dev, info ) << "Needed memory for the time series of " << getFileNames().front() << ": "
+					 << m_TimeSeriesBuffer.size() * sizeof( float ) / ( 1024.0 * 1024.0 ) << " mb.";
+	float *timeSeries = reinterpret_cast<float *>( ( reinterpret_cast<uintptr_t>( &m_TimeSeriesBuffer[0] ) + 31 ) & ~static_cast<uintptr_t>( 31 ) );
+
+	operation::Correlation::createTimeSeries( image, timeSeries );
+
+	m_TimeSeries = timeSeries;
+	m_TimeSeriesPending = false;
+}
+
+void ImageHolder::readTimeSeries( const util::ivector4 &voxel, std::vector<double> &dest )
+{
+	readProfile( voxel, 3, dest );
+}
+
+void ImageHolder::readProfile( const util::ivector4 &voxel, const unsigned short &axis, std::vector<double> &dest )
+{
+	dest.resize( m_ImageSize[axis] );
+
+	if( dest.empty() ) {
+		return;
+	}
+
+	const float *timeSeries = axis == 3 ? getTimeSeries() : 0;
+
+	if( timeSeries ) {
+		const float *series = timeSeries + ( ( voxel[2] * m_ImageSize[1] + voxel[1] ) * m_ImageSize[0] + voxel[0] ) * getTimeSeriesStride();
+		std::copy( series, series + m_ImageSize[3], dest.begin() );
+	} else {
+		readLine( voxel, axis, &dest[0] );
+	}
+}
+
+void ImageHolder::readLine( const util::ivector4 &voxel, const unsigned short &axis, double *dest ) const
+{
+	util::ivector4 coords = voxel;
+
+	//the line crosses the chunks one after another, all of them have the same size
+	for( size_t i = 0; i < m_ImageSize[axis]; ) {
+		coords[axis] = i;
+		const data::Chunk chunk = m_Image->getChunk( coords[0], coords[1], coords[2], coords[3], false );
+		const util::FixedVector<size_t, 4> chunkSize = chunk.getSizeAsVector();
+		const size_t cx = coords[0] % chunkSize[0], cy = coords[1] % chunkSize[1], cz = coords[2] % chunkSize[2], ct = coords[3] % chunkSize[3];
+		const size_t length = std::min<size_t>( chunkSize[axis] - coords[axis] % chunkSize[axis], m_ImageSize[axis] - i );
+		size_t stride = 1;
+
+		for( unsigned short dim = 0; dim < axis; dim++ ) {
+			stride *= chunkSize[dim];
+		}
+
+		switch( chunk.getTypeID() ) {
+		case data::ValuePtr<bool>::staticID:
+			copyStrided( &chunk.voxel<bool>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		case data::ValuePtr<int8_t>::staticID:
+			copyStrided( &chunk.voxel<int8_t>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		case data::ValuePtr<uint8_t>::staticID:
+			copyStrided( &chunk.voxel<uint8_t>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		case data::ValuePtr<int16_t>::staticID:
+			copyStrided( &chunk.voxel<int16_t>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		case data::ValuePtr<uint16_t>::staticID:
+			copyStrided( &chunk.voxel<uint16_t>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		case data::ValuePtr<int32_t>::staticID:
+			copyStrided( &chunk.voxel<int32_t>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		case data::ValuePtr<uint32_t>::staticID:
+			copyStrided( &chunk.voxel<uint32_t>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		case data::ValuePtr<int64_t>::staticID:
+			copyStrided( &chunk.voxel<int64_t>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		case data::ValuePtr<uint64_t>::staticID:
+			copyStrided( &chunk.voxel<uint64_t>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		case data::ValuePtr<float>::staticID:
+			copyStrided( &chunk.voxel<float>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		case data::ValuePtr<double>::staticID:
+			copyStrided( &chunk.voxel<double>( cx, cy, cz, ct ), stride, dest + i, length );
+			break;
+		default:
+			std::fill( dest + i, dest + i + length, 0 );
+			break;
 		}
 
-		//      #pragma omp parallel for
-		for( size_t i = 0; i < volume; i++ ) {
-			if( dataPtr[i] > 0 ) {
-				histogramVectorWOZero[t][dataPtr[i] - 1]++;
+		i += length;
+	}
+}
+
+util::fvector4 ImageHolder::getPhysicalStep( const unsigned short &axis ) const
+{
+	util::ivector4 next;
+	next[axis] = 1;
+	return m_Image->getPhysicalCoordsFromIndex( next ) - m_Image->getPhysicalCoordsFromIndex( util::ivector4() );
+}
+
+template<typename DEST>
+void ImageHolder::convertVolume( const size_t &timestep, DEST *dest, const ConversionParameters &parameters, bool parallel ) const
+{
+	const data::Image &image = *m_Image;
+	const double scaling = parameters.scaling;
+	const double offset = parameters.offset;
+
+	//the chunks of an image all have the same size, so the position inside the chunk is the position in the image modulo the chunk size
+	#pragma omp parallel for schedule( dynamic ) if( parallel )
+
+	for( int64_t z = 0; z < static_cast<int64_t>( m_ImageSize[2] ); z++ ) {
+		for( size_t y = 0; y < m_ImageSize[1]; y++ ) {
+			const data::Chunk chunk = image.getChunk( 0, y, z, timestep, false );
+			const util::FixedVector<size_t, 4> chunkSize = chunk.getSizeAsVector();
+			const size_t cy = y % chunkSize[1], cz = z % chunkSize[2], ct = timestep % chunkSize[3];
+			DEST *destRow = dest + ( z * m_ImageSize[1] + y ) * m_ImageSize[0];
+
+			switch( chunk.getTypeID() ) {
+			case data::ValuePtr<bool>::staticID:
+				convertRow<bool>( &chunk.voxel<bool>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			case data::ValuePtr<int8_t>::staticID:
+				convertRow<int8_t>( &chunk.voxel<int8_t>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			case data::ValuePtr<uint8_t>::staticID:
+				convertRow<uint8_t>( &chunk.voxel<uint8_t>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			case data::ValuePtr<int16_t>::staticID:
+				convertRow<int16_t>( &chunk.voxel<int16_t>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			case data::ValuePtr<uint16_t>::staticID:
+				convertRow<uint16_t>( &chunk.voxel<uint16_t>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			case data::ValuePtr<int32_t>::staticID:
+				convertRow<int32_t>( &chunk.voxel<int32_t>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			case data::ValuePtr<uint32_t>::staticID:
+				convertRow<uint32_t>( &chunk.voxel<uint32_t>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			case data::ValuePtr<int64_t>::staticID:
+				convertRow<int64_t>( &chunk.voxel<int64_t>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			case data::ValuePtr<uint64_t>::staticID:
+				convertRow<uint64_t>( &chunk.voxel<uint64_t>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			case data::ValuePtr<float>::staticID:
+				convertRow<float>( &chunk.voxel<float>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			case data::ValuePtr<double>::staticID:
+				convertRow<double>( &chunk.voxel<double>( 0, cy, cz, ct ), destRow, m_ImageSize[0], scaling, offset, m_ReserveZero, m_ReservedValue );
+				break;
+			default:
+				LOG( Runtime, error ) << "Can not convert data of type " << chunk.getTypeName() << " to the internal data type!";
+				std::fill( destRow, destRow + m_ImageSize[0], m_ReservedValue );
+				break;
 			}
 		}
 	}
 }
 
+const double *ImageHolder::getHistogram( const size_t &timestep, bool omitZero, bool parallel )
+{
+	if( m_HistogramRevisions[timestep] != m_DataRevision ) {
+		computeHistogram( timestep, parallel );
+		m_HistogramRevisions[timestep] = m_DataRevision;
+	}
+
+	return &m_Histograms[timestep][omitZero ? 1 : 0];
+}
+
+double ImageHolder::getHistogramBinValue( const size_t &bin ) const
+{
+	//high precision values are shifted into the bins of InternalImageType by computeHistogram
+	const double binWidth = m_HighPrecision ? ( std::numeric_limits<InternalImageHighPrecisionType>::max() + 1.0 ) / ( std::numeric_limits<InternalImageType>::max() + 1.0 ) : 1;
+	return ( bin * binWidth - m_OffsetToInternal ) / m_ScalingToInternal;
+}
+
+void ImageHolder::computeHistogram( const size_t &timestep, bool parallel )
+{
+	const data::Chunk volume = getVolume( timestep, parallel );
+
+	if( volume.getTypeID() == data::ValuePtr<InternalImageHighPrecisionType>::staticID ) {
+		computeHistogram( &volume.voxel<InternalImageHighPrecisionType>( 0, 0, 0 ), timestep, parallel );
+	} else {
+		computeHistogram( &volume.voxel<InternalImageType>( 0, 0, 0 ), timestep, parallel );
+	}
+}
+
+template<typename TYPE>
+void ImageHolder::computeHistogram( const TYPE *dataPtr, const size_t &timestep, bool parallel )
+{
+	//the histogram always has one bin per value of InternalImageType, high precision values are shifted into these bins
+	const unsigned short shift = ( sizeof( TYPE ) - sizeof( InternalImageType ) ) * 8;
+	const long nVoxels = m_ImageSize[0] * m_ImageSize[1] * m_ImageSize[2];
+	//every thread counts into 4 interleaved sub-histograms, so runs of equal values do not wait for their own previous increment
+	const size_t nBins = std::numeric_limits<InternalImageType>::max() + 1;
+	const size_t nSubHistograms = 4;
+	size_t nThreads = 1;
+#ifdef _OPENMP
+
+	if( parallel ) {
+		nThreads = omp_get_max_threads();
+	}
+
+#endif
+	m_HistogramBuffer.resize( nThreads * nSubHistograms * nBins );
+	std::fill( m_HistogramBuffer.begin(), m_HistogramBuffer.end(), 0 );
+	uint32_t *buffer = &m_HistogramBuffer[0];
+
+	#pragma omp parallel num_threads( nThreads )
+	{
+		size_t thread = 0;
+#ifdef _OPENMP
+		thread = omp_get_thread_num();
+#endif
+		uint32_t *const sub0 = buffer + thread * nSubHistograms * nBins;
+		uint32_t *const sub1 = sub0 + nBins;
+		uint32_t *const sub2 = sub1 + nBins;
+		uint32_t *const sub3 = sub2 + nBins;
+		const long nBlocks = nVoxels / 4;
+
+		#pragma omp for schedule( static )
+		for( long block = 0; block < nBlocks; block++ ) {
+			const TYPE *values = dataPtr + block * 4;
+			sub0[values[0] >> shift]++;
+			sub1[values[1] >> shift]++;
+			sub2[values[2] >> shift]++;
+			sub3[values[3] >> shift]++;
+		}
+	}
+
+	std::vector<double> &histogram = m_Histograms[timestep];
+
+	for( size_t bin = 0; bin < nBins; bin++ ) {
+		uint32_t count = 0;
+
+		for( size_t sub = 0; sub < nThreads * nSubHistograms; sub++ ) {
+			count += buffer[sub * nBins + bin];
+		}
+
+		histogram[bin] = count;
+	}
+
+	for( long i = ( nVoxels / 4 ) * 4; i < nVoxels; i++ ) {
+		histogram[dataPtr[i] >> shift]++;
+	}
+}
+
 
 
 ///calls isis::data::Image::updateOrientationMatrices() and sets latchedOrientation and orientation of the isis::viewer::ImageHolder
@@ -344,7 +815,168 @@ void ImageHolder::updateOrientation()
 	rowVec = getISISImage()->getPropertyAs<util::fvector4>("rowVec");
 	columnVec = getISISImage()->getPropertyAs<util::fvector4>("columnVec");
 	sliveVec = getISISImage()->getPropertyAs<util::fvector4>("sliveVec");
+	compileOrientationMappings();
+	m_OrientationRevision++;
+}
 
+namespace
+{
+OrientationMapping compileMapping( const boost::numeric::ublas::matrix<double> &matrix )
+{
+	OrientationMapping mapping;
+
+	for( size_t i = 0; i < 4; i++ ) {
+		mapping.axis[i] = i;
+		mapping.sign[i] = 0;
+
+		for( size_t j = 0; j < 4; j++ ) {
+			if( matrix( i, j ) != 0 ) {
+				mapping.axis[i] = j;
+				mapping.sign[i] = matrix( i, j ) < 0 ? -1 : 1;
+				break;
+			}
+		}
+	}
+
+	return mapping;
+}
+}
+
+void ImageHolder::compileOrientationMappings()
+{
+	using namespace boost::numeric::ublas;
+
+	for( unsigned short plane = 0; plane < 3; plane++ ) {
+		matrix<double> transformMatrix = identity_matrix<double>( 4, 4 );
+
+		switch ( plane ) {
+		case axial:
+			/*setup axial matrix
+			*-1  0  0
+			* 0 -1  0
+			* 0  0  1
+			*/
+			transformMatrix( 0, 0 ) = -1;
+			transformMatrix( 1, 1 ) = 1;
+			break;
+		case sagittal:
+			/*setup sagittal matrix
+			* 0  1  0
+			* 0  0  1
+			* 1  0  0
+			*/
+			transformMatrix( 0, 0 ) = 0;
+			transformMatrix( 2, 0 ) = 1;
+			transformMatrix( 0, 1 ) = 1;
+			transformMatrix( 2, 2 ) = 0;
+			transformMatrix( 1, 2 ) = -1;
+			transformMatrix( 1, 1 ) = 0;
+			break;
+		case coronal:
+			/*setup coronal matrix
+			* -1  0  0
+			*  0  0  1
+			*  0  1  0
+			*/
+			transformMatrix( 0, 0 ) = -1;
+			transformMatrix( 1, 1 ) = 0;
+			transformMatrix( 2, 2 ) = 0;
+			transformMatrix( 2, 1 ) = 1;
+			transformMatrix( 1, 2 ) = -1;
+			break;
+		}
+
+		//both matrices only have one nonzero entry of +-1 per row, so they can be compiled into a signed permutation
+		const matrix<double> planeMatrix = prod( transformMatrix, latchedOrientation );
+		m_OrientationMappings[plane][0] = compileMapping( planeMatrix );
+		m_OrientationMappings[plane][1] = compileMapping( trans( planeMatrix ) );
+	}
+}
+
+void ImageHolder::voxelDataChanged()
+{
+	m_DataRevision++;
+	m_FullChangeRevision = m_DataRevision;
+	m_ChangedRegions.clear();
+}
+
+void ImageHolder::voxelDataChanged( const util::ivector4 &start, const util::ivector4 &end )
+{
+	m_DataRevision++;
+
+	//voxels written one after another would fill the history quickly, so a box that touches the last one is merged into it
+	if( !m_ChangedRegions.empty() ) {
+		ChangedRegion &last = m_ChangedRegions.back();
+		bool touches = true;
+
+		for( size_t i = 0; i < 4; i++ ) {
+			touches &= last.start[i] <= end[i] + 1 && start[i] <= last.end[i] + 1;
+		}
+
+		if( touches ) {
+			for( size_t i = 0; i < 4; i++ ) {
+				last.start[i] = std::min( last.start[i], start[i] );
+				last.end[i] = std::max( last.end[i], end[i] );
+			}
+
+			last.revision = m_DataRevision;
+			return;
+		}
+	}
+
+	const ChangedRegion region = { m_DataRevision, m_DataRevision, start, end };
+	m_ChangedRegions.push_back( region );
+
+	if( m_ChangedRegions.size() > 256 ) {
+		m_ChangedRegions.pop_front();
+	}
+}
+
+bool ImageHolder::isVoxelDataChanged( const size_t &revision, const util::ivector4 &start, const util::ivector4 &end ) const
+{
+	if( revision == m_DataRevision ) {
+		return false;
+	}
+
+	if( revision > m_DataRevision || revision < m_FullChangeRevision || m_ChangedRegions.empty() || m_ChangedRegions.front().first > revision + 1 ) {
+		return true;
+	}
+
+	for( std::deque<ChangedRegion>::const_reverse_iterator iter = m_ChangedRegions.rbegin(); iter != m_ChangedRegions.rend() && iter->revision > revision; iter++ ) {
+		bool intersects = true;
+
+		for( size_t i = 0; i < 4; i++ ) {
+			intersects &= iter->start[i] <= end[i] && start[i] <= iter->end[i];
+		}
+
+		if( intersects ) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ImageHolder::getChangedRegion( const size_t &revision, util::ivector4 &start, util::ivector4 &end ) const
+{
+	if( revision > m_DataRevision || revision < m_FullChangeRevision ||
+		( revision < m_DataRevision && ( m_ChangedRegions.empty() || m_ChangedRegions.front().first > revision + 1 ) ) ) {
+		return false;
+	}
+
+	for( size_t i = 0; i < 4; i++ ) {
+		start[i] = m_ImageSize[i];
+		end[i] = -1;
+	}
+
+	for( std::deque<ChangedRegion>::const_reverse_iterator iter = m_ChangedRegions.rbegin(); iter != m_ChangedRegions.rend() && iter->revision > revision; iter++ ) {
+		for( size_t i = 0; i < 4; i++ ) {
+			start[i] = std::min( start[i], iter->start[i] );
+			end[i] = std::max( end[i], iter->end[i] );
+		}
+	}
+
+	return true;
 }
 
 void ImageHolder::checkVoxelCoords( util::ivector4 &vc )
@@ -358,8 +990,35 @@ void ImageHolder::checkVoxelCoords( util::ivector4 &vc )
 
 void ImageHolder::updateColorMap()
 {
-	if( !isRGB ) {
-		util::Singletons::get<color::Color, 10>().adaptColorMapToImage( this );
+	if( isRGB ) {
+		return;
+	}
+
+	const color::ColormapParameters parameters = color::Color::getColormapParameters( this );
+
+	//global window/level updates all images, most of them did not change
+	if( parameters != m_ColormapParameters ) {
+		m_ColormapParameters = parameters;
+
+		if( m_HighPrecision ) {
+			//the window is applied by the window LUT while the slices are extracted, so the colormap itself is not windowed
+			color::ColormapParameters unwindowed = parameters;
+			unwindowed.scaling = 1;
+			unwindowed.offset = 0;
+			colorMap = util::Singletons::get<color::Color, 10>().getAdaptedColormap( unwindowed );
+			const boost::shared_ptr<WindowLUTType> windowLUT( new WindowLUTType( std::numeric_limits<InternalImageHighPrecisionType>::max() + 1 ) );
+			color::Color::computeWindowLUT( parameters, &( *windowLUT )[0], windowLUT->size() );
+			{
+				QMutexLocker locker( &m_VolumeMutex );
+				m_WindowLUT = windowLUT;
+			}
+			//the extracted slices depend on the window LUT, but the voxel data itself is unchanged
+			m_WindowLUTRevision++;
+		} else {
+			colorMap = util::Singletons::get<color::Color, 10>().getAdaptedColormap( parameters );
+		}
+
+		m_ColorMapRevision++;
 	}
 }
 
@@ -389,51 +1048,9 @@ void ImageHolder::logImageProps() const
 	
 }
 
-void ImageHolder::setVoxel ( const size_t& first, const size_t& second, const size_t& third, const size_t& fourth, const double& value, bool sync )
+void ImageHolder::setVoxel ( const size_t &first, const size_t &second, const size_t &third, const size_t &fourth, const double &value, bool sync )
 {
-	data::Chunk chunk = getISISImage()->getChunk( first, second, third, fourth, false );
-	getChunkVector()[fourth].voxel<InternalImageType>( first, second, third ) = scalingToInternalType.second->as<double>() + value * scalingToInternalType.first->as<double>();
-	if( sync ) {
-		switch( chunk.getTypeID() ) {
-			case data::ValuePtr<bool>::staticID:
-				chunk.voxel<bool>(first, second, third, fourth) = static_cast<bool>( value );
-				break;
-			case data::ValuePtr<uint8_t>::staticID:
-				chunk.voxel<uint8_t>(first, second, third, fourth) = static_cast<uint8_t>( value );
-				break;
-			case data::ValuePtr<int8_t>::staticID:
-				chunk.voxel<int8_t>(first, second, third, fourth) = static_cast<int8_t>( value );
-				break;
-			case data::ValuePtr<uint16_t>::staticID:
-				chunk.voxel<uint16_t>(first, second, third, fourth) = static_cast<uint16_t>( value );
-				break;
-			case data::ValuePtr<int16_t>::staticID:
-				chunk.voxel<int16_t>(first, second, third, fourth) = static_cast<int16_t>( value );
-				break;
-			case data::ValuePtr<uint32_t>::staticID:
-				chunk.voxel<uint32_t>(first, second, third, fourth) = static_cast<uint32_t>( value );
-				break;
-			case data::ValuePtr<int32_t>::staticID:
-				chunk.voxel<int32_t>(first, second, third, fourth) = static_cast<int32_t>( value );
-				break;
-			case data::ValuePtr<uint64_t>::staticID:
-				chunk.voxel<uint64_t>(first, second, third, fourth) = static_cast<uint64_t>( value );
-				break;
-			case data::ValuePtr<int64_t>::staticID:
-				chunk.voxel<int64_t>(first, second, third, fourth) = static_cast<int64_t>( value );
-				break;
-			case data::ValuePtr<float>::staticID:
-				chunk.voxel<float>(first, second, third, fourth) = static_cast<float>( value );
-				break;
-			case data::ValuePtr<double>::staticID:
-				chunk.voxel<double>(first, second, third, fourth) = static_cast<double>( value );
-				break;
-			default:
-				LOG( Runtime, error ) << "Tried to set voxel of chunk with type " << chunk.getTypeName() << " to double";
-				LOG( Dev, error ) << "ImageHolder::setVoxel with type " << chunk.getTypeName();
-
-		}
-	}
+	setTypedVoxel<double>( first, second, third, fourth, value, sync );
 }
 
 
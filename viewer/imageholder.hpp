@@ -30,12 +30,18 @@
 
 #include <boost/foreach.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
+#include <boost/enable_shared_from_this.hpp>
 #include <vector>
+#include <deque>
+#include <set>
+#include <limits>
+#include <QMutex>
 #include <CoreUtils/propmap.hpp>
 #include <DataStorage/image.hpp>
 #include "common.hpp"
 #include "color.hpp"
 #include "widgetinterface.hpp"
+#include "correlation.hpp"
 #include "common.hpp"
 
 namespace isis
@@ -48,32 +54,89 @@ namespace color
 class Color;
 }
 class WidgetInterface;
+
+/**
+ * Signed permutation that maps voxel coordinates of an image to the coordinates of a plane or back.
+ * Axis i of the result is sign[i] * coords[axis[i]].
+ */
+struct OrientationMapping {
+	uint8_t axis[4];
+	///-1 or 1, 0 if no axis is mapped to axis i
+	int8_t sign[4];
+};
+
 /**
  * Class that holds one image in a vector of data::ValuePtr's
  * It ensures the data is hold in continuous memory and only consists of one type.
  * Furthermore this class handles the meta information of the image
  */
 
-class ImageHolder
+class ImageHolder : public boost::enable_shared_from_this<ImageHolder>
 {
 
 
 public:
 	typedef std::list<boost::shared_ptr< ImageHolder > > ImageListType;
 	typedef data::_internal::ValuePtrBase::Reference ImagePointerType;
+	///maps every value of InternalImageHighPrecisionType to an index of the colormap
+	typedef std::vector<uint8_t> WindowLUTType;
 
 	enum ImageType { structural_image, z_map };
 
 	ImageHolder();
 
-	bool setImage( const data::Image &image, const ImageType &imageType, const std::string &filename = "" );
+	///sets the image and converts its first volume. If parallel is false this is done by the calling thread only, e.g. on a loader thread.
+	bool setImage( const data::Image &image, const ImageType &imageType, const std::string &filename = "", bool parallel = true );
 
 	size_t getID() const { return m_ID; }
 	void setID( size_t id ) { m_ID = id; }
 
-	std::vector< ImagePointerType > getImageVector() const { return m_ImageVector; }
-	const std::vector< data::Chunk > &getChunkVector() const { return m_ChunkVector; }
-	std::vector< data::Chunk > &getChunkVector() { return m_ChunkVector; }
+	/**
+	 * Returns the volume of the given timestep in the internal data type.
+	 * This is InternalImageType or InternalImageHighPrecisionType if isHighPrecision() is true.
+	 * If the volume is not resident it is converted from the source image first.
+	 * The returned chunk shares its memory with the holder and stays valid even if the volume gets evicted meanwhile.
+	 * If parallel is true a conversion uses all OpenMP threads. Callers that already run on a worker thread should pass false.
+	 */
+	data::Chunk getVolume( const size_t &timestep, bool parallel = true );
+	bool isVolumeResident( const size_t &timestep ) const;
+	/**
+	 * Converts the count volumes following timestep on worker threads, so they are resident when they are displayed.
+	 * Wraps around at the last timestep like the time course playback does.
+	 */
+	void prefetchVolumes( const size_t &timestep, const size_t &count );
+	/**
+	 * Sets the maximum number of converted volumes that are kept in memory. 0 means no limit.
+	 * If the limit is reached the least recently used volume is evicted.
+	 * This only bounds the internal representation. The source image is kept as it was loaded.
+	 * Has to be set before setImage. Evicted volumes are converted again from the source image,
+	 * so changes of the internal data that were not synchronized with the source image are lost.
+	 */
+	void setMaxResidentVolumes( const size_t &maxResidentVolumes ) { m_MaxResidentVolumes = maxResidentVolumes; }
+	const size_t &getMaxResidentVolumes() const { return m_MaxResidentVolumes; }
+	/**
+	 * Selects InternalImageHighPrecisionType as internal data type. Only possible for structural images that are no color images.
+	 * The 8 bit index of the colormap is then computed from the 16 bit values by the window LUT while the slices are extracted,
+	 * so narrow windows still get all 256 colors. This needs twice the memory, so it should be kept off for large 4D images.
+	 * Can be changed at any time, the resident volumes are converted again.
+	 */
+	void setHighPrecision( bool highPrecision );
+	bool isHighPrecision() const { return m_HighPrecision; }
+	/**
+	 * Replaces the scaling of the source values into the internal type that was computed by setImage.
+	 * scalingToInternalType must not be changed directly, as writeRegion and the conversion of the volumes use the scaling set here.
+	 * The resident volumes are converted again with the new scaling when they are requested.
+	 */
+	void setInternalScaling( const double &scaling, const double &offset );
+	/**
+	 * Scaling and offset of the internal values into the range 0..255 the colormap is adapted to.
+	 * Images of InternalImageType keep their values internally to share the memory of the source image,
+	 * so their contrast is stretched by the colormap instead. For all other images this is 1 and 0.
+	 */
+	double getColormapIndexScaling() const { return m_ColormapIndexScaling; }
+	double getColormapIndexOffset() const { return m_ColormapIndexOffset; }
+	///returns the window LUT of an image with high precision. It is replaced when the scaling, offset or extent change.
+	boost::shared_ptr<const WindowLUTType> getWindowLUT() const;
 	util::PropertyMap &getPropMap() { return m_PropMap; }
 	const util::PropertyMap &getPropMap() const { return m_PropMap; }
 	const util::FixedVector<size_t, 4> &getImageSize() const { return m_ImageSize; }
@@ -84,11 +147,13 @@ public:
 	bool removeChangedAttribute( const std::string &attribute );
 
 	boost::weak_ptr<void>
-	getImageWeakPointer( size_t timestep = 0 ) const {
-		return getImageVector()[timestep]->getRawAddress();
+	getImageWeakPointer( size_t timestep = 0 ) {
+		return getVolume( timestep ).asValuePtrBase().getRawAddress();
 	}
 
 	util::slist getFileNames() const { return m_Filenames; }
+	///replaces the name the image is listed with
+	void setFileName( const std::string &fileName ) { m_Filenames.front() = fileName; }
 
 	bool operator<( const ImageHolder &ref ) const { return m_ID < ref.getID(); }
 
@@ -97,6 +162,7 @@ public:
 	void setZeroIsReserved( bool isReserved ) { m_ZeroIsReserved = isReserved; }
 	double getInternalExtent()  const;
 
+	///adapts the colormap to lut, scaling, offset and thresholds. Does nothing if none of them changed since the last call.
 	void updateColorMap();
 
 	void addWidget( WidgetInterface *widget ) { m_WidgetList.push_back( widget ); }
@@ -104,16 +170,199 @@ public:
 	std::list< WidgetInterface * > getWidgetList() { return m_WidgetList; }
 
 	void updateOrientation();
-	void updateHistogram();
+	///the mapping of voxel coordinates to the plane orientation (or back if back is true). It is compiled from latchedOrientation by updateOrientation.
+	const OrientationMapping &getOrientationMapping( const PlaneOrientation &orientation, bool back = false ) const { return m_OrientationMappings[orientation][back ? 1 : 0]; }
+	/**
+	 * Returns the histogram of the internal data of the given timestep.
+	 * It has one bin per value of InternalImageType. If omitZero is true, the returned array starts with the bin of value 1.
+	 * The histogram is computed when it is requested for the first time after the data has changed.
+	 * If parallel is false it is computed by the calling thread only.
+	 */
+	const double *getHistogram( const size_t &timestep, bool omitZero = false, bool parallel = true );
+	///returns the value of the source image that is mapped to the lower bound of the given histogram bin
+	double getHistogramBinValue( const size_t &bin ) const;
+
+	///has to be called whenever the voxel data of the internal chunks was changed, so cached slices are extracted again
+	void voxelDataChanged();
+	///marks only the voxels in the box from start to end ( both inclusive ) as changed, so slices outside of it are kept
+	void voxelDataChanged( const util::ivector4 &start, const util::ivector4 &end );
+	/**
+	 * Returns true if voxels in the box from start to end ( both inclusive ) have changed after revision.
+	 * Revisions that are too old to be covered by the recorded regions count as a change of the whole image.
+	 */
+	bool isVoxelDataChanged( const size_t &revision, const util::ivector4 &start, const util::ivector4 &end ) const;
+	/**
+	 * Computes the bounding box ( both inclusive ) of all voxels that have changed after revision.
+	 * Returns false if the changes are not covered by the recorded regions, i.e. the whole image has to be considered as changed.
+	 * If nothing has changed start is greater than end.
+	 */
+	bool getChangedRegion( const size_t &revision, util::ivector4 &start, util::ivector4 &end ) const;
+	///revision of the voxel data
+	size_t getDataRevision() const { return m_DataRevision; }
+	///revision of the colormap, increased whenever updateColorMap changed it
+	size_t getColorMapRevision() const { return m_ColorMapRevision; }
+	///revision of the orientation, increased by updateOrientation. Extracted slices depend on it, the voxel data does not.
+	size_t getOrientationRevision() const { return m_OrientationRevision; }
+	///revision of the window LUT, increased whenever updateColorMap replaced it. Slices of high precision images depend on it.
+	size_t getWindowLUTRevision() const { return m_WindowLUTRevision; }
+
+	/**
+	 * Starts building the time-contiguous copy of a 4D image in the background.
+	 * This copy holds the values of the source image as float, all timesteps of a voxel next to each other.
+	 * It is built once and reflects the source image at that time.
+	 * It is kept in addition to the source image, so it should only be requested by features that read many time courses.
+	 */
+	void requestTimeSeries();
+	/**
+	 * Returns the time-contiguous copy or 0 if it is not built (yet). If wait is true it is built first if necessary.
+	 * The series of voxel (x,y,z) starts at ( ( z * sizeY + y ) * sizeX + x ) * getTimeSeriesStride() and is 32 byte aligned.
+	 * The padding behind the getImageSize()[3] values of a series is zero.
+	 */
+	const float *getTimeSeries( bool wait = false );
+	size_t getTimeSeriesStride() const { return operation::Correlation::getStride( m_ImageSize[3] ); }
+	/**
+	 * Reads the time course of a voxel. The time-contiguous copy is used if it is available, the source image otherwise.
+	 */
+	void readTimeSeries( const util::ivector4 &voxel, std::vector<double> &dest );
+	/**
+	 * Reads the values of the source image along axis (0-3) through voxel, so dest holds getImageSize()[axis] values.
+	 * Chunk and type are resolved once per chunk on the line, the values inside a chunk are copied with a strided loop.
+	 * Time courses come from the time-contiguous copy if it is available.
+	 */
+	void readProfile( const util::ivector4 &voxel, const unsigned short &axis, std::vector<double> &dest );
+	///physical distance of two neighbouring voxels along the image axis (0-2)
+	util::fvector4 getPhysicalStep( const unsigned short &axis ) const;
+
+	/**
+	 * Writes a box of voxels from a buffer of TYPE. The box starts at start and has the extent size in all four dimensions.
+	 * src holds size[0] * size[1] * size[2] * size[3] values, x running fastest.
+	 * The values are scaled into the internal volumes row by row. If sync is true they are also converted to the type of the source image and written there.
+	 * Chunks and scaling are resolved once per row, so this should be used instead of setTypedVoxel to write many voxels.
+	 * Marks the voxel data as changed.
+	 */
+	template<typename TYPE>
+	void writeRegion( const TYPE *src, const util::ivector4 &start, const util::ivector4 &size, bool sync = true ) {
+		if( isRGB ) {
+			LOG( Dev, error ) << "ImageHolder::writeRegion is not supported for color images";
+			return;
+		}
+
+		for( size_t i = 0; i < 4; i++ ) {
+			if( start[i] < 0 || size[i] < 1 || static_cast<size_t>( start[i] + size[i] ) > m_ImageSize[i] ) {
+				LOG( Dev, error ) << "ImageHolder::writeRegion with start " << start << " and size " << size << " exceeds the image size " << m_ImageSize;
+				return;
+			}
+		}
+
+		const int64_t rows = size[1] * size[2];
+		std::vector<data::Chunk> chunks;
+		std::vector<size_t> rowChunks( sync ? rows : 0 );
+
+		for( int32_t t = 0; t < size[3]; t++ ) {
+			data::Chunk volume = getVolume( start[3] + t );
+			const TYPE *srcVolume = src + t * rows * size[0];
+			const size_t timestep = start[3] + t;
+			void *volumeData = volume.asValuePtrBase().getRawAddress().get();
+
+			//the chunks are looked up before the parallel loop, so it neither asks the image for them nor copies them
+			if( sync ) {
+				chunks.clear();
+				util::FixedVector<size_t, 4> chunkSize;
+				size_t lastBlock = 0;
+
+				for( int64_t row = 0; row < rows; row++ ) {
+					const size_t y = start[1] + row % size[1], z = start[2] + row / size[1];
+
+					//all chunks have the same size, so the chunk of a row is known from its position
+					if( chunks.empty() || ( z / chunkSize[2] ) * m_ImageSize[1] + y / chunkSize[1] != lastBlock ) {
+						chunks.push_back( m_Image->getChunk( start[0], y, z, timestep, false ) );
+						chunkSize = chunks.back().getSizeAsVector();
+						lastBlock = ( z / chunkSize[2] ) * m_ImageSize[1] + y / chunkSize[1];
+					}
+
+					rowChunks[row] = chunks.size() - 1;
+				}
+			}
+
+			#pragma omp parallel for if( rows > 64 )
+
+			for( int64_t row = 0; row < rows; row++ ) {
+				const size_t y = start[1] + row % size[1], z = start[2] + row / size[1];
+				const size_t index = ( z * m_ImageSize[1] + y ) * m_ImageSize[0] + start[0];
+				const TYPE *srcRow = srcVolume + row * size[0];
+
+				if( m_HighPrecision ) {
+					convertRow<TYPE>( srcRow, static_cast<InternalImageHighPrecisionType *>( volumeData ) + index, size[0], m_ScalingToInternal, m_OffsetToInternal, m_ReserveZero, m_ReservedValue );
+				} else {
+					convertRow<TYPE>( srcRow, static_cast<InternalImageType *>( volumeData ) + index, size[0], m_ScalingToInternal, m_OffsetToInternal, m_ReserveZero, m_ReservedValue );
+				}
+
+				if( sync ) {
+					data::Chunk &chunk = chunks[rowChunks[row]];
+					const util::FixedVector<size_t, 4> chunkSize = chunk.getSizeAsVector();
+					storeRow<TYPE>( srcRow, chunk, start[0] % chunkSize[0], y % chunkSize[1], z % chunkSize[2], timestep % chunkSize[3], size[0] );
+				}
+			}
+		}
+
+		util::ivector4 end;
+
+		for( size_t i = 0; i < 4; i++ ) {
+			end[i] = start[i] + size[i] - 1;
+		}
+
+		voxelDataChanged( start, end );
+	}
+
+	///writes the slice with the given z index of one timestep. src holds getImageSize()[0] * getImageSize()[1] values.
+	template<typename TYPE>
+	void writeSlice( const TYPE *src, const size_t &slice, const size_t &timestep, bool sync = true ) {
+		writeRegion<TYPE>( src, util::ivector4( 0, 0, slice, timestep ), util::ivector4( m_ImageSize[0], m_ImageSize[1], 1, 1 ), sync );
+	}
+
+	///writes a whole volume. src holds getImageSize()[0] * getImageSize()[1] * getImageSize()[2] values.
+	template<typename TYPE>
+	void writeVolume( const TYPE *src, const size_t &timestep, bool sync = true ) {
+		writeRegion<TYPE>( src, util::ivector4( 0, 0, 0, timestep ), util::ivector4( m_ImageSize[0], m_ImageSize[1], m_ImageSize[2], 1 ), sync );
+	}
 
 	void setVoxel( const size_t &first, const size_t &second, const size_t &third, const size_t &fourth, const double &value, bool sync = true );
 
+	///writes a single voxel directly. Use writeRegion to write many voxels.
 	template<typename TYPE>
 	void setTypedVoxel(  const size_t &first, const size_t &second, const size_t &third, const size_t &fourth, const TYPE &value, bool sync = true ) {
-		getChunkVector()[fourth].voxel<InternalImageType>(first, second, third) = static_cast<double>( value ) * scalingToInternalType.first->as<double>() + scalingToInternalType.second->as<double>();
+		if( isRGB || first >= m_ImageSize[0] || second >= m_ImageSize[1] || third >= m_ImageSize[2] || fourth >= m_ImageSize[3] ) {
+			LOG( Dev, error ) << "ImageHolder::setTypedVoxel can not write voxel " << util::ivector4( first, second, third, fourth );
+			return;
+		}
+
+		data::Chunk volume = getVolume( fourth );
+
+		if( m_HighPrecision ) {
+			volume.voxel<InternalImageHighPrecisionType>( first, second, third ) = convertToInternal<TYPE, InternalImageHighPrecisionType>( value );
+		} else {
+			volume.voxel<InternalImageType>( first, second, third ) = convertToInternal<TYPE, InternalImageType>( value );
+		}
+
 		if( sync ) {
-			getISISImage()->getChunk(first, second, third, fourth, false).voxel<TYPE>(first, second, third, fourth ) = value;
+			data::Chunk chunk = m_Image->getChunk( first, second, third, fourth, false );
+			const util::FixedVector<size_t, 4> chunkSize = chunk.getSizeAsVector();
+			storeRow<TYPE>( &value, chunk, first % chunkSize[0], second % chunkSize[1], third % chunkSize[2], fourth % chunkSize[3], 1 );
 		}
+
+		const util::ivector4 voxel( first, second, third, fourth );
+		voxelDataChanged( voxel, voxel );
+	}
+
+	/**
+	 * Converts a value of the source image to the internal type DEST ( InternalImageType or InternalImageHighPrecisionType ) the way the volumes are converted.
+	 * Together with getVolume this allows writing both representations directly.
+	 */
+	template<typename TYPE, typename DEST>
+	DEST convertToInternal( const TYPE &value ) const {
+		DEST ret;
+		convertRow( &value, &ret, 1, m_ScalingToInternal, m_OffsetToInternal, m_ReserveZero, m_ReservedValue );
+		return ret;
 	}
 
 	util::ivector4 voxelCoords;
@@ -142,8 +391,6 @@ public:
 	boost::numeric::ublas::matrix<double> latchedOrientation;
 	unsigned short majorTypeID;
 	std::string majorTypeName;
-	std::vector< double *> histogramVector;
-	std::vector< double *> histogramVectorWOZero;
 	std::pair<util::ValueReference, util::ValueReference> scalingToInternalType;
 
 private:
@@ -155,27 +402,112 @@ private:
 
 	bool m_ZeroIsReserved;
 	InternalImageType m_ReservedValue;
+	size_t m_DataRevision;
+	///last revision that changed the whole image
+	size_t m_FullChangeRevision;
+	///the box changed by the revisions first to revision. Touching changes of consecutive revisions are merged into one region.
+	struct ChangedRegion {
+		size_t first;
+		size_t revision;
+		util::ivector4 start;
+		util::ivector4 end;
+	};
+	///regions changed by the revisions after m_FullChangeRevision, the oldest first. Only the last 256 are kept.
+	std::deque<ChangedRegion> m_ChangedRegions;
+	size_t m_ColorMapRevision;
+	size_t m_OrientationRevision;
+	bool m_ReserveZero;
+	size_t m_MaxResidentVolumes;
+	bool m_HighPrecision;
+	boost::shared_ptr<const WindowLUTType> m_WindowLUT;
+	size_t m_WindowLUTRevision;
 
 	boost::shared_ptr<data::Image> m_Image;
 	util::slist m_Filenames;
 	size_t m_ID;
 	std::pair<double, double> m_OptimalScalingPair;
-
-	std::vector< ImagePointerType > m_ImageVector;
-	std::vector< data::Chunk > m_ChunkVector;
+	///scalingToInternalType as double, so it is not converted for every row
+	double m_ScalingToInternal;
+	double m_OffsetToInternal;
+	double m_ColormapIndexScaling;
+	double m_ColormapIndexOffset;
+	///increased whenever the resident volumes are dropped because the conversion changed. m_VolumeMutex has to be locked.
+	size_t m_ConversionGeneration;
+
+	///the converted volumes. Volumes that are not resident are null.
+	std::vector< boost::shared_ptr<data::Chunk> > m_ChunkVector;
+	///access tick of every volume, used to find the least recently used one
+	std::vector<size_t> m_LastAccess;
+	size_t m_AccessCounter;
+	size_t m_ResidentCount;
+	///volumes that are queued for prefetching
+	std::set<size_t> m_PendingVolumes;
+	///guards m_ChunkVector and everything above
+	mutable QMutex m_VolumeMutex;
+
+	std::vector< std::vector<double> > m_Histograms;
+	///data revision each histogram was computed for
+	std::vector<size_t> m_HistogramRevisions;
+	///per thread sub-histograms, kept to avoid allocating them for every histogram
+	std::vector<uint32_t> m_HistogramBuffer;
+
+	std::vector<float> m_TimeSeriesBuffer;
+	///aligned start of m_TimeSeriesBuffer, 0 as long as it is not built
+	float *m_TimeSeries;
+	bool m_TimeSeriesPending;
+	///locked while the time series are built
+	QMutex m_TimeSeriesMutex;
 
 	std::list<WidgetInterface *> m_WidgetList;
 
+	///forward and backward mapping for every plane orientation
+	OrientationMapping m_OrientationMappings[3][2];
+	void compileOrientationMappings();
+
 	boost::shared_ptr<color::Color> m_ColorHandler;
+	///parameters colorMap was adapted to
+	color::ColormapParameters m_ColormapParameters;
+
+	///everything the conversion of a volume depends on. It is taken while m_VolumeMutex is locked, so the conversion can run without the lock.
+	struct ConversionParameters {
+		double scaling;
+		double offset;
+		bool highPrecision;
+		///m_ConversionGeneration at the time the parameters were taken
+		size_t generation;
+	};
+	ConversionParameters getConversionParameters() const;
+	///converts the volume. If parallel is true its slices are converted by all OpenMP threads.
+	data::Chunk loadVolume( const size_t &timestep, bool parallel = true );
+	/**
+	 * Returns the volume of the source image itself if it already is in the internal format:
+	 * same type, no scaling, no reserved zero and one chunk covering the whole volume. Returns null otherwise.
+	 * Such a volume shares its memory with the source image, so writing to it also changes the source image.
+	 */
+	boost::shared_ptr<data::Chunk> shareVolume( const size_t &timestep, const unsigned short &typeID, const ConversionParameters &parameters ) const;
+	template<typename DEST>
+	boost::shared_ptr<data::Chunk> createVolume( const size_t &timestep, const ConversionParameters &parameters, bool parallel ) const;
+	template<typename DEST>
+	void convertVolume( const size_t &timestep, DEST *dest, const ConversionParameters &parameters, bool parallel ) const;
+	///sets the scaling to the internal type and internMinMax
+	void initInternalScaling();
+	///evicts the least recently used volumes until the limit is met. m_VolumeMutex has to be locked.
+	void evictVolumes();
+	void computeHistogram( const size_t &timestep, bool parallel );
+	template<typename TYPE>
+	void computeHistogram( const TYPE *dataPtr, const size_t &timestep, bool parallel );
+	static void prefetchVolume( boost::shared_ptr<ImageHolder> image, size_t timestep );
+	void buildTimeSeries();
+	static void prefetchTimeSeries( boost::shared_ptr<ImageHolder> image );
 
 	template<typename TYPE>
-	void copyImageToVector( const data::Image &image, bool reserveZero ) {
-		data::ValuePtr<TYPE> imagePtr( ( TYPE * ) calloc( image.getVolume(), sizeof( TYPE ) ), image.getVolume() );
-		LOG( Dev, info) << "Needed memory: " << image.getVolume() * sizeof( TYPE ) / ( 1024.0 * 1024.0 ) << " mb.";
+	void setScalingToInternalType( const data::Image &image, bool reserveZero ) {
+		m_ColormapIndexScaling = 1;
+		m_ColormapIndexOffset = 0;
 
 		if( reserveZero ) {
 			LOG( Dev, info ) << "0 is reserved";
-			// calculate new scaling  
+			// calculate new scaling
 			data::scaling_pair scalingPair = image.getScalingTo( data::ValuePtr<TYPE>::staticID, data::upscale );
 			double scaling = scalingPair.first->as<double>();
 			double offset = scalingPair.second->as<double>();
@@ -183,41 +515,148 @@ private:
 			offset += 1;
 			const data::scaling_pair newScaling( std::make_pair< util::ValueReference, util::ValueReference>( util::Value<double>( scaling ), util::Value<double>( offset ) ) ) ;
 			scalingToInternalType = newScaling;
+		} else if( data::ValuePtr<TYPE>::staticID == data::ValuePtr<InternalImageType>::staticID && image.getMajorTypeID() == data::ValuePtr<TYPE>::staticID ) {
+			//masks and label images often do not span the whole range. Upscaling them would prevent sharing the source memory,
+			//so the values are kept and the colormap stretches them instead
+			LOG( Dev, info ) << "0 is not reserved, the values are kept";
+			const data::scaling_pair upscale = image.getScalingTo( data::ValuePtr<TYPE>::staticID, data::upscale );
+			m_ColormapIndexScaling = upscale.first->as<double>();
+			m_ColormapIndexOffset = upscale.second->as<double>();
+			scalingToInternalType.first = util::Value<double>( 1 );
+			scalingToInternalType.second = util::Value<double>( 0 );
 		} else {
 			LOG( Dev, info ) << "0 is not reserved";
 			scalingToInternalType = image.getScalingTo( data::ValuePtr<TYPE>::staticID, data::upscale );
 		}
+
 		LOG( Dev, info ) << "scalingToInternalType: " << scalingToInternalType.first->as<double>() << " : " << scalingToInternalType.second->as<double>();
+	}
+
+	template<typename TYPE>
+	static void copyStrided( const TYPE *src, const size_t &stride, double *dest, const size_t &length ) {
+		for( size_t i = 0; i < length; i++ ) {
+			dest[i] = src[i * stride];
+		}
+	}
+
+	///reads the values along axis through voxel from the chunks of the source image
+	void readLine( const util::ivector4 &voxel, const unsigned short &axis, double *dest ) const;
+
+	template<typename SRC, typename DEST>
+	static void castRow( const SRC *src, DEST *dest, const size_t &length ) {
+		for( size_t x = 0; x < length; x++ ) {
+			dest[x] = static_cast<DEST>( src[x] );
+		}
+	}
+
+	///writes one row of TYPE to the position x,y,z,t of the chunk, converting it to the type of the chunk
+	template<typename TYPE>
+	static void storeRow( const TYPE *src, data::Chunk &chunk, const size_t &x, const size_t &y, const size_t &z, const size_t &t, const size_t &length ) {
+		switch( chunk.getTypeID() ) {
+		case data::ValuePtr<bool>::staticID:
+			castRow( src, &chunk.voxel<bool>( x, y, z, t ), length );
+			break;
+		case data::ValuePtr<int8_t>::staticID:
+			castRow( src, &chunk.voxel<int8_t>( x, y, z, t ), length );
+			break;
+		case data::ValuePtr<uint8_t>::staticID:
+			castRow( src, &chunk.voxel<uint8_t>( x, y, z, t ), length );
+			break;
+		case data::ValuePtr<int16_t>::staticID:
+			castRow( src, &chunk.voxel<int16_t>( x, y, z, t ), length );
+			break;
+		case data::ValuePtr<uint16_t>::staticID:
+			castRow( src, &chunk.voxel<uint16_t>( x, y, z, t ), length );
+			break;
+		case data::ValuePtr<int32_t>::staticID:
+			castRow( src, &chunk.voxel<int32_t>( x, y, z, t ), length );
+			break;
+		case data::ValuePtr<uint32_t>::staticID:
+			castRow( src, &chunk.voxel<uint32_t>( x, y, z, t ), length );
+			break;
+		case data::ValuePtr<int64_t>::staticID:
+			castRow( src, &chunk.voxel<int64_t>( x, y, z, t ), length );
+			break;
+		case data::ValuePtr<uint64_t>::staticID:
+			castRow( src, &chunk.voxel<uint64_t>( x, y, z, t ), length );
+			break;
+		case data::ValuePtr<float>::staticID:
+			castRow( src, &chunk.voxel<float>( x, y, z, t ), length );
+			break;
+		case data::ValuePtr<double>::staticID:
+			castRow( src, &chunk.voxel<double>( x, y, z, t ), length );
+			break;
+		default:
+			LOG( Runtime, error ) << "Can not write voxels to a chunk of type " << chunk.getTypeName() << "!";
+			break;
+		}
+	}
+
+	///copies the whole image at once into continuous memory and splices it into volumes. Only used for color images.
+	template<typename TYPE>
+	void copyImageToVector( const data::Image &image, bool reserveZero ) {
+		setScalingToInternalType<TYPE>( image, reserveZero );
+
+		for( size_t timestep = 0; timestep < m_ImageSize[3]; timestep++ ) {
+			const boost::shared_ptr<data::Chunk> volume = shareVolume( timestep, data::ValuePtr<TYPE>::staticID, getConversionParameters() );
+
+			if( !volume ) {
+				break;
+			}
+
+			m_ChunkVector.push_back( volume );
+		}
+
+		if( m_ChunkVector.size() == m_ImageSize[3] ) {
+			internMinMax = image.getMinMax();
+			m_ResidentCount = m_ChunkVector.size();
+			return;
+		}
+
+		m_ChunkVector.clear();
+		data::ValuePtr<TYPE> imagePtr( ( TYPE * ) calloc( image.getVolume(), sizeof( TYPE ) ), image.getVolume() );
+		LOG( Dev, info ) << "Needed memory: " << image.getVolume() * sizeof( TYPE ) / ( 1024.0 * 1024.0 ) << " mb.";
 		image.copyToMem<TYPE>( &imagePtr[0], image.getVolume(), scalingToInternalType );
 		LOG( Dev, verbose_info ) << "Copied image to continuous memory space.";
 		internMinMax = imagePtr.getMinMax();
 		LOG( Dev, info ) << "internMinMax: " << internMinMax.first->as<double>() << " : " << internMinMax.second->as<double>();
+		std::vector< ImagePointerType > imageVector;
+
 		//splice the image in its volumes -> we get a vector of t volumes
 		if( m_ImageSize[3] > 1 ) { //splicing is only necessary if we got more than 1 timestep
-			m_ImageVector = imagePtr.splice( m_ImageSize[0] * m_ImageSize[1] * m_ImageSize[2] );
+			imageVector = imagePtr.splice( m_ImageSize[0] * m_ImageSize[1] * m_ImageSize[2] );
 		} else {
-			m_ImageVector.push_back( imagePtr );
+			imageVector.push_back( imagePtr );
+		}
+
+		BOOST_FOREACH( std::vector< ImagePointerType >::const_reference pointerRef, imageVector ) {
+			m_ChunkVector.push_back( boost::shared_ptr<data::Chunk>( new data::Chunk( pointerRef, m_ImageSize[0], m_ImageSize[1], m_ImageSize[2] ) ) );
 		}
+
+		m_ResidentCount = m_ChunkVector.size();
 	}
 
-	template<typename TYPE>
-	void _setTrueZero( const data::Image &image ) {
-		// first make shure the images datatype is consistent
-		data::TypedImage<TYPE> tImage ( image );
-// 		now set all voxels to the m_ReservedValue that are 0 in the origin image
-		for( size_t t = 0; t < getImageSize()[3]; t++ ) {
-			for( size_t z = 0; z < getImageSize()[2]; z++ ) {
-				for( size_t y = 0; y < getImageSize()[1]; y++ ) {
-#pragma omp parallel for
-					for( size_t x = 0; x < getImageSize()[0]; x++ ) {
-						if( static_cast<data::Image &>( tImage ).voxel<TYPE>( x, y, z, t ) == static_cast<TYPE>( 0 ) ) {
-							m_ChunkVector[t].voxel<InternalImageType>( x, y, z ) = m_ReservedValue;
-						}
-					}
-				}
+	///scales one row of the source image into the internal type DEST. Voxels that are 0 in the source are set to the reserved value if reserveZero is true.
+	template<typename TYPE, typename DEST>
+	static void convertRow( const TYPE *src, DEST *dest, const size_t &length, const double &scaling, const double &offset, const bool &reserveZero, const InternalImageType &reservedValue ) {
+		const double minValue = std::numeric_limits<DEST>::min();
+		const double maxValue = std::numeric_limits<DEST>::max();
+
+		//the loops only contain selects, so the compiler can vectorize them. The zero reservation is blended in instead of branching.
+		if( reserveZero ) {
+			const DEST reserved = static_cast<DEST>( reservedValue );
+
+			for( size_t x = 0; x < length; x++ ) {
+				const double value = src[x] * scaling + offset + 0.5;
+				const DEST converted = static_cast<DEST>( value <= minValue ? minValue : value >= maxValue ? maxValue : value );
+				dest[x] = src[x] == static_cast<TYPE>( 0 ) ? reserved : converted;
+			}
+		} else {
+			for( size_t x = 0; x < length; x++ ) {
+				const double value = src[x] * scaling + offset + 0.5;
+				dest[x] = static_cast<DEST>( value <= minValue ? minValue : value >= maxValue ? maxValue : value );
 			}
 		}
-
 	}
 };
 
@@ -29,41 +29,41 @@
 
 boost::shared_ptr< isis::viewer::QProgressFeedback > isis::viewer::operation::NativeImageOps::m_ProgressFeedback;
 
-isis::util::ivector4 isis::viewer::operation::NativeImageOps::getGlobalMin( const boost::shared_ptr< isis::viewer::ImageHolder > image, const util::ivector4 &startPos, const unsigned short &radius )
+isis::util::ivector4 isis::viewer::operation::NativeImageOps::getGlobalMin( const boost::shared_ptr< isis::viewer::ImageHolder > image, const util::ivector4 &startPos, const unsigned short &radius, bool allTimesteps )
 {
 	switch ( image->getISISImage()->getMajorTypeID() ) {
 	case data::ValuePtr<bool>::staticID:
-		return internGetMax<bool>( image, startPos, radius );
+		return internFindExtremum<bool, Less<bool> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<int8_t>::staticID:
-		return internGetMin<int8_t>( image, startPos, radius );
+		return internFindExtremum<int8_t, Less<int8_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<uint8_t>::staticID:
-		return internGetMin<uint8_t>( image, startPos, radius );
+		return internFindExtremum<uint8_t, Less<uint8_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<int16_t>::staticID:
-		return internGetMin<int16_t>( image, startPos, radius );
+		return internFindExtremum<int16_t, Less<int16_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<uint16_t>::staticID:
-		return internGetMin<uint16_t>( image, startPos, radius );
+		return internFindExtremum<uint16_t, Less<uint16_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<int32_t>::staticID:
-		return internGetMin<int32_t>( image, startPos, radius );
+		return internFindExtremum<int32_t, Less<int32_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<uint32_t>::staticID:
-		return internGetMin<uint32_t>( image, startPos, radius );
+		return internFindExtremum<uint32_t, Less<uint32_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<int64_t>::staticID:
-		return internGetMin<int64_t>( image, startPos, radius );
+		return internFindExtremum<int64_t, Less<int64_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<uint64_t>::staticID:
-		return internGetMin<uint64_t>( image, startPos, radius );
+		return internFindExtremum<uint64_t, Less<uint64_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<float>::staticID:
-		return internGetMin<float>( image, startPos, radius );
+		return internFindExtremum<float, Less<float> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<double>::staticID:
-		return internGetMin<double>( image, startPos, radius );
+		return internFindExtremum<double, Less<double> >( image, startPos, radius, allTimesteps );
 		break;
 	default:
 		LOG( Runtime, error ) << "Search of min/max is not suported for " << image->getISISImage()->getMajorTypeID() << " !";
@@ -72,41 +72,41 @@ isis::util::ivector4 isis::viewer::operation::NativeImageOps::getGlobalMin( cons
 	}
 }
 
-isis::util::ivector4 isis::viewer::operation::NativeImageOps::getGlobalMax( const boost::shared_ptr< isis::viewer::ImageHolder > image, const util::ivector4 &startPos, const unsigned short &radius )
+isis::util::ivector4 isis::viewer::operation::NativeImageOps::getGlobalMax( const boost::shared_ptr< isis::viewer::ImageHolder > image, const util::ivector4 &startPos, const unsigned short &radius, bool allTimesteps )
 {
 	switch ( image->getISISImage()->getMajorTypeID() ) {
 	case data::ValuePtr<bool>::staticID:
-		return internGetMax<bool>( image, startPos, radius );
+		return internFindExtremum<bool, Greater<bool> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<int8_t>::staticID:
-		return internGetMax<int8_t>( image, startPos, radius );
+		return internFindExtremum<int8_t, Greater<int8_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<uint8_t>::staticID:
-		return internGetMax<uint8_t>( image, startPos, radius );
+		return internFindExtremum<uint8_t, Greater<uint8_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<int16_t>::staticID:
-		return internGetMax<int16_t>( image, startPos, radius );
+		return internFindExtremum<int16_t, Greater<int16_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<uint16_t>::staticID:
-		return internGetMax<uint16_t>( image, startPos, radius );
+		return internFindExtremum<uint16_t, Greater<uint16_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<int32_t>::staticID:
-		return internGetMax<int32_t>( image, startPos, radius );
+		return internFindExtremum<int32_t, Greater<int32_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<uint32_t>::staticID:
-		return internGetMax<uint32_t>( image, startPos, radius );
+		return internFindExtremum<uint32_t, Greater<uint32_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<int64_t>::staticID:
-		return internGetMax<int64_t>( image, startPos, radius );
+		return internFindExtremum<int64_t, Greater<int64_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<uint64_t>::staticID:
-		return internGetMax<uint64_t>( image, startPos, radius );
+		return internFindExtremum<uint64_t, Greater<uint64_t> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<float>::staticID:
-		return internGetMax<float>( image, startPos, radius );
+		return internFindExtremum<float, Greater<float> >( image, startPos, radius, allTimesteps );
 		break;
 	case data::ValuePtr<double>::staticID:
-		return internGetMax<double>( image, startPos, radius );
+		return internFindExtremum<double, Greater<double> >( image, startPos, radius, allTimesteps );
 		break;
 	default:
 		LOG( Runtime, error ) << "Search of min/max is not suported for " << image->getISISImage()->getMajorTypeID() << " !";
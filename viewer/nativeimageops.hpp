@@ -32,6 +32,7 @@
 
 #include <boost/concept_check.hpp>
 #include <numeric>
+#include <algorithm>
 #include "qprogressfeedback.hpp"
 #include "imageholder.hpp"
 #include <DataStorage/image.hpp>
@@ -48,88 +49,133 @@ class NativeImageOps
 	static boost::shared_ptr< QProgressFeedback > m_ProgressFeedback;
 public:
 
-	static util::ivector4 getGlobalMin( const boost::shared_ptr<ImageHolder> image, const util::ivector4 &startPos, const unsigned short &radius );
-	static util::ivector4 getGlobalMax( const boost::shared_ptr<ImageHolder> image, const util::ivector4 &startPos, const unsigned short &radius );
+	/**
+	 * Returns the voxel position of the minimum inside the box of the given radius around startPos.
+	 * If radius is 0 the whole volume is searched. Only the timestep of startPos is searched unless allTimesteps is set.
+	 */
+	static util::ivector4 getGlobalMin( const boost::shared_ptr<ImageHolder> image, const util::ivector4 &startPos, const unsigned short &radius, bool allTimesteps = false );
+	/// Same as getGlobalMin but for the maximum
+	static util::ivector4 getGlobalMax( const boost::shared_ptr<ImageHolder> image, const util::ivector4 &startPos, const unsigned short &radius, bool allTimesteps = false );
 
 	static void setProgressFeedBack( boost::shared_ptr< QProgressFeedback > progressFeedback );
 
 private:
 
-	template<typename TYPE>
-	static util::ivector4 internGetMin( const boost::shared_ptr<ImageHolder> image, const util::ivector4 &startPos, const unsigned short &radius ) {
-		const util::ivector4 size = image->getImageSize();
-		util::ivector4 start;
-		util::ivector4 end;
-        const size_t timestep = image->voxelCoords[3];
-		if( radius ) {
-			for( size_t i = 0; i < 3; i++ ) {
-				start[i] = ( startPos[i] - radius ) < 0 ? 0 : startPos[i] - radius;
-				end[i] = ( startPos[i] + radius ) > size[i] ? size[i] : startPos[i] + radius;
-			}
-		} else {
-			start = util::ivector4( 0, 0, 0, 0 );
-			end = size;
+	template<typename TYPE> struct Less {
+		bool operator()( const TYPE &a, const TYPE &b ) const { return a < b; }
+	};
+	template<typename TYPE> struct Greater {
+		bool operator()( const TYPE &a, const TYPE &b ) const { return a > b; }
+	};
+
+	/**
+	 * Searches the extremum of a contiguous row.
+	 * The value is found first with a branch free reduction the compiler can vectorize, its first position afterwards.
+	 * NaNs are skipped. Returns false if the row does not contain any valid value.
+	 */
+	template<typename TYPE, typename COMPARE>
+	static bool scanRow( const TYPE *row, const size_t &length, TYPE &extremum, size_t &index ) {
+		const COMPARE compare;
+		TYPE value = row[0];
+
+		for( size_t i = 1; i < length; i++ ) {
+			value = ( compare( row[i], value ) || value != value ) ? row[i] : value;
 		}
 
-		util::ivector4 currentPos;
-		TYPE currentValue;
-		data::TypedImage<TYPE> typedImage = *image->getISISImage();
-		TYPE currentMin = std::numeric_limits<TYPE>::max();
-		#pragma omp parallel for
+		if( value != value ) {
+			return false;
+		}
 
-		for( int32_t z = start[2] + 1; z < end[2]; z++ ) {
-			for( int32_t y = start[1] + 1; y < end[1]; y++ ) {
-				for( int32_t x = start[0] + 1; x < end[0]; x++ ) {
-					currentValue = static_cast<data::Image &>( typedImage ).voxel<TYPE>( x, y, z, timestep );
+		index = 0;
 
-					if( currentValue < currentMin ) {
-						currentPos = util::ivector4( x, y, z, timestep );
-						currentMin = currentValue;
-					}
-				}
-			}
+		while( row[index] != value ) {
+			index++;
 		}
 
-		return currentPos;
+		extremum = value;
+		return true;
+	}
+
+	static size_t linearIndex( const util::ivector4 &pos, const util::ivector4 &size ) {
+		return ( ( static_cast<size_t>( pos[3] ) * size[2] + pos[2] ) * size[1] + pos[1] ) * size[0] + pos[0];
 	}
 
-	template<typename TYPE>
-	static util::ivector4 internGetMax( const boost::shared_ptr<ImageHolder> image, const util::ivector4 &startPos, const unsigned short &radius ) {
+	template<typename TYPE, typename COMPARE>
+	static util::ivector4 internFindExtremum( const boost::shared_ptr<ImageHolder> image, const util::ivector4 &startPos, const unsigned short &radius, bool allTimesteps ) {
 		const util::ivector4 size = image->getImageSize();
-		util::ivector4 start;
-		util::ivector4 end;
-        const size_t timestep = image->voxelCoords[3];
-		
+		const data::Image &isisImage = *image->getISISImage();
+		util::ivector4 start( 0, 0, 0, startPos[3] );
+		util::ivector4 end( size[0], size[1], size[2], startPos[3] + 1 );
+
 		if( radius ) {
 			for( size_t i = 0; i < 3; i++ ) {
-				start[i] = ( startPos[i] - radius ) < 0 ? 0 : startPos[i] - radius;
-				end[i] = ( startPos[i] + radius ) > size[i] ? size[i] : startPos[i] + radius;
+				start[i] = std::max<int32_t>( startPos[i] - radius, 0 );
+				end[i] = std::min<int32_t>( startPos[i] + radius + 1, size[i] );
 			}
-		} else {
-			start = util::ivector4( 0, 0, 0, 0 );
-			end = size;
 		}
 
-		util::ivector4 currentPos;
-		TYPE currentValue;
-		data::TypedImage<TYPE> typedImage = *image->getISISImage();
-		TYPE currentMax = std::numeric_limits<TYPE>::min();
-		#pragma omp parallel for
+		if( allTimesteps ) {
+			start[3] = 0;
+			end[3] = size[3];
+		}
+
+		const int32_t rowsPerVolume = ( end[1] - start[1] ) * ( end[2] - start[2] );
+		const int32_t numberOfRows = rowsPerVolume * ( end[3] - start[3] );
+		const size_t rowLength = end[0] - start[0];
+		const COMPARE compare;
+
+		bool found = false;
+		TYPE bestValue = TYPE();
+		util::ivector4 bestPos = startPos;
+
+		#pragma omp parallel
+		{
+			bool threadFound = false;
+			TYPE threadValue = TYPE();
+			util::ivector4 threadPos;
+
+			//static scheduling hands every thread ascending rows, so only replacing on a strictly better value keeps the first occurrence
+			#pragma omp for schedule( static )
+
+			for( int32_t row = 0; row < numberOfRows; row++ ) {
+				const int32_t t = start[3] + row / rowsPerVolume;
+				const int32_t z = start[2] + ( row % rowsPerVolume ) / ( end[1] - start[1] );
+				const int32_t y = start[1] + ( row % rowsPerVolume ) % ( end[1] - start[1] );
+				const data::Chunk chunk = isisImage.getChunk( 0, y, z, t, false );
+
+				if( chunk.getTypeID() != data::ValuePtr<TYPE>::staticID ) {
+					LOG( Dev, warning ) << "Skipping row of type " << chunk.getTypeName() << " while searching for min/max.";
+					continue;
+				}
 
-		for( int32_t z = start[2] + 1; z < end[2]; z++ ) {
-			for( int32_t y = start[1] + 1; y < end[1]; y++ ) {
-				for( int32_t x = start[0] + 1; x < end[0]; x++ ) {
-					currentValue = static_cast<data::Image &>( typedImage ).voxel<TYPE>( x, y, z, timestep );
+				const util::FixedVector<size_t, 4> chunkSize = chunk.getSizeAsVector();
+				TYPE rowValue;
+				size_t index;
 
-					if( currentValue > currentMax ) {
-						currentPos = util::ivector4( x, y, z, timestep );
-						currentMax = currentValue;
+				if( scanRow<TYPE, COMPARE>( &chunk.voxel<TYPE>( start[0], y % chunkSize[1], z % chunkSize[2], t % chunkSize[3] ), rowLength, rowValue, index )
+					&& ( !threadFound || compare( rowValue, threadValue ) ) ) {
+					threadFound = true;
+					threadValue = rowValue;
+					threadPos = util::ivector4( start[0] + static_cast<int32_t>( index ), y, z, t );
+				}
+			}
+
+			#pragma omp critical
+			{
+				if( threadFound ) {
+					//ties are resolved to the position that comes first in memory so the result does not depend on the number of threads
+					const bool better = !found || compare( threadValue, bestValue )
+										|| ( threadValue == bestValue && linearIndex( threadPos, size ) < linearIndex( bestPos, size ) );
+
+					if( better ) {
+						found = true;
+						bestValue = threadValue;
+						bestPos = threadPos;
 					}
 				}
 			}
 		}
-
-		return currentPos;
+		return bestPos;
 	}
 };
 
@@ -33,6 +33,7 @@
 #include <mainwindow.hpp>
 
 #include <fstream>
+#include <QtConcurrentRun>
 
 namespace isis
 {
@@ -150,6 +151,12 @@ void QViewerCore::receiveMessage ( std::string message )
 
 void QViewerCore::physicalCoordsChanged ( util::fvector4 physicalCoords )
 {
+	//the voxel coords are calculated once here instead of in every widget
+	BOOST_FOREACH ( DataContainer::reference image, getDataContainer() )
+	{
+		image.second->physicalCoords = physicalCoords;
+		image.second->voxelCoords = image.second->getISISImage()->getIndexFromPhysicalCoords ( physicalCoords, true );
+	}
 	emitPhysicalCoordsChanged ( physicalCoords );
 }
 
@@ -169,12 +176,22 @@ void QViewerCore::timestepChanged ( int timestep )
 			if ( static_cast<size_t> ( timestep ) < image.second->getImageSize() [3] )
 			{
 				image.second->voxelCoords[3] = timestep;
+				image.second->prefetchVolumes ( timestep, getOptionMap()->getPropertyAs<uint16_t> ( "prefetchVolumes" ) );
 			}
 		}
 		updateScene();
 	}
 }
 
+void QViewerCore::prefetchTimesteps ( int timestep, int count )
+{
+	BOOST_FOREACH ( DataContainer::reference image, getDataContainer() )
+	{
+		image.second->prefetchVolumes ( timestep, count );
+	}
+	emitPrefetchTimesteps ( timestep, count );
+}
+
 std::list<boost::shared_ptr<ImageHolder> > QViewerCore::addImageList ( const std::list< data::Image > imageList, const ImageHolder::ImageType &imageType )
 {
 	std::list<boost::shared_ptr<ImageHolder> > retList = isis::viewer::ViewerCoreBase::addImageList ( imageList, imageType );
@@ -356,53 +373,192 @@ void QViewerCore::openPath ( const _internal::FileInformation &fileInfo )
 {
 	if ( !fileInfo.getFileName().empty() )
 	{
-		getUICore()->getMainWindow()->toggleLoadingIcon( true, QString( "Opening image " ) + fileInfo.getFileName().c_str() + QString("...") );
 		QDir dir;
 		setCurrentPath ( dir.absoluteFilePath ( fileInfo.getFileName().c_str() ).toStdString() );
-		UICore::ViewWidgetEnsembleType ensemble;
+		PendingLoad load ( fileInfo );
+		load.canceled.reset ( new QAtomicInt ( 0 ) );
+		load.watcher = new QFutureWatcher<ImageHolder::ImageListType> ( this );
+		connect ( load.watcher, SIGNAL ( finished() ), this, SLOT ( loadingFinished() ) );
+		m_PendingLoads.push_back ( load );
+		load.watcher->setFuture ( QtConcurrent::run ( &QViewerCore::loadImages, fileInfo,
+								  static_cast<size_t> ( getOptionMap()->getPropertyAs<uint16_t> ( "maxResidentVolumes" ) ),
+								  getOptionMap()->getPropertyAs<bool> ( "highPrecisionStructural" ), load.canceled,
+								  //several loads at once convert on their own threads only
+								  m_PendingLoads.size() == 1 ) );
+		getUICore()->getMainWindow()->toggleLoadingIcon( true, QString( "Opening image " ) + fileInfo.getFileName().c_str() + QString("...") );
+	}
+}
+
+ImageHolder::ImageListType QViewerCore::loadImages ( const _internal::FileInformation fileInfo, const size_t maxResidentVolumes, const bool highPrecision, boost::shared_ptr<QAtomicInt> canceled, const bool parallel )
+{
+	ImageHolder::ImageListType retList;
 
-		if ( getUICore()->getEnsembleList().size() )
+	//the job may have been canceled while it was waiting for a thread
+	if ( canceled && *canceled )
+	{
+		LOG ( Runtime, info ) << "Loading of " << fileInfo.getFileName() << " was canceled.";
+		return retList;
+	}
+
+	QTime clock;
+	clock.start();
+	//IOFactory::load can not be interrupted, so a cancel request only takes effect once the file is read
+	const std::list<data::Image> tempImgList = isis::data::IOFactory::load ( fileInfo.getFileName() , fileInfo.getReadFormat(), fileInfo.getDialect() );
+	LOG ( Runtime, info ) << "Loading " << fileInfo.getFileName() << " took " << clock.restart() / 1000.0 << " seconds.";
+	BOOST_FOREACH ( std::list<data::Image>::const_reference image, tempImgList )
+	{
+		if ( canceled && *canceled )
 		{
-			ensemble = getUICore()->getEnsembleList().front();
+			break;
 		}
-		boost::filesystem::path p ( fileInfo.getFileName() );
 
-		std::list<data::Image> tempImgList = isis::data::IOFactory::load ( fileInfo.getFileName() , fileInfo.getReadFormat(), fileInfo.getDialect() );
-		if( !tempImgList.empty() ) {
-			m_RecentFiles.insert( std::make_pair<std::string, _internal::FileInformation>(fileInfo.getFileName(), fileInfo ) );
-		}
-		BOOST_FOREACH ( std::list<data::Image>::const_reference image, tempImgList )
+		boost::shared_ptr<ImageHolder> imageHolder = DataContainer::createImageHolder ( image, fileInfo.getImageType(), maxResidentVolumes, highPrecision, parallel );
+
+		//the histogram of the first volume is needed as soon as the image is shown
+		if ( !imageHolder->isRGB )
 		{
-			boost::shared_ptr<ImageHolder> imageHolder = addImage ( image, fileInfo.getImageType() );
-			checkForCaCp ( imageHolder );
+			imageHolder->getHistogram ( 0, false, parallel );
+		}
+
+		retList.push_back ( imageHolder );
+	}
+
+	//dropping everything here frees the memory as soon as the worker is done
+	if ( canceled && *canceled )
+	{
+		LOG ( Runtime, info ) << "Loading of " << fileInfo.getFileName() << " was canceled.";
+		return ImageHolder::ImageListType();
+	}
+
+	LOG ( Runtime, info ) << "Converting " << retList.size() << " image(s) of " << fileInfo.getFileName() << " took " << clock.elapsed() / 1000.0 << " seconds.";
+	return retList;
+}
+
+namespace
+{
+class LoadJob : public QRunnable
+{
+public:
+	LoadJob ( const _internal::FileInformation &fileInfo, const size_t &maxResidentVolumes, const bool &highPrecision, ImageHolder::ImageListType &result )
+		: m_FileInfo ( fileInfo ), m_MaxResidentVolumes ( maxResidentVolumes ), m_HighPrecision ( highPrecision ), m_Result ( result ) {}
+	//the pool already runs one job per thread, so every job converts its images on its own thread only
+	void run() { m_Result = QViewerCore::loadImages ( m_FileInfo, m_MaxResidentVolumes, m_HighPrecision, boost::shared_ptr<QAtomicInt>(), false ); }
+private:
+	const _internal::FileInformation m_FileInfo;
+	const size_t m_MaxResidentVolumes;
+	const bool m_HighPrecision;
+	ImageHolder::ImageListType &m_Result;
+};
+}
+
+std::vector<ImageHolder::ImageListType> QViewerCore::loadFiles ( const std::list<_internal::FileInformation> &fileList )
+{
+	std::vector<ImageHolder::ImageListType> retVector ( fileList.size() );
+	const int numberOfThreads = getOptionMap()->getPropertyAs<uint16_t> ( "numberOfThreads" );
+	const size_t maxResidentVolumes = getOptionMap()->getPropertyAs<uint16_t> ( "maxResidentVolumes" );
+	const bool highPrecision = getOptionMap()->getPropertyAs<bool> ( "highPrecisionStructural" );
+	QThreadPool pool;
+	pool.setMaxThreadCount ( numberOfThreads ? numberOfThreads : QThread::idealThreadCount() );
+	QTime clock;
+	clock.start();
+	size_t index = 0;
+	BOOST_FOREACH ( std::list<_internal::FileInformation>::const_reference fileInfo, fileList )
+	{
+		//every job writes to its own entry, so the order of fileList is kept
+		pool.start ( new LoadJob ( fileInfo, maxResidentVolumes, highPrecision, retVector[index++] ) );
+	}
+
+	//keep the loading icon moving
+	while ( !pool.waitForDone ( 100 ) )
+	{
+		QApplication::processEvents ( QEventLoop::ExcludeUserInputEvents );
+	}
+
+	LOG ( Runtime, info ) << "Loading " << fileList.size() << " file(s) with " << pool.maxThreadCount() << " thread(s) took "
+						  << clock.elapsed() / 1000.0 << " seconds.";
+	return retVector;
+}
+
+void QViewerCore::loadingFinished()
+{
+	//images are added in the order they were opened, even if a later one finished first
+	while ( !m_PendingLoads.empty() && m_PendingLoads.front().watcher->isFinished() )
+	{
+		const PendingLoad load = m_PendingLoads.front();
+		m_PendingLoads.pop_front();
+		const ImageHolder::ImageListType images = load.watcher->result();
+		load.watcher->deleteLater();
+		addLoadedImages ( load.fileInfo, images );
+	}
+
+	if ( m_PendingLoads.empty() )
+	{
+		getUICore()->getMainWindow()->toggleLoadingIcon( false );
+	}
+}
+
+void QViewerCore::cancelLoading()
+{
+	if ( m_PendingLoads.empty() )
+	{
+		return;
+	}
+
+	BOOST_FOREACH ( std::list<PendingLoad>::const_reference load, m_PendingLoads )
+	{
+		*load.canceled = 1;
+		//the result is not needed anymore, so nobody keeps the images once the worker returns
+		load.watcher->disconnect ( this );
+		load.watcher->deleteLater();
+	}
+	m_PendingLoads.clear();
+	getUICore()->getMainWindow()->toggleLoadingIcon( false );
+}
+
+void QViewerCore::addLoadedImages ( const _internal::FileInformation &fileInfo, const ImageHolder::ImageListType &images )
+{
+	if ( images.empty() )
+	{
+		return;
+	}
 
-			if ( ! ( getMode() == ViewerCoreBase::zmap && imageHolder->imageType == ImageHolder::structural_image ) )
+	UICore::ViewWidgetEnsembleType ensemble;
+
+	if ( getUICore()->getEnsembleList().size() )
+	{
+		ensemble = getUICore()->getEnsembleList().front();
+	}
+
+	m_RecentFiles.insert( std::make_pair<std::string, _internal::FileInformation>(fileInfo.getFileName(), fileInfo ) );
+	BOOST_FOREACH ( ImageHolder::ImageListType::const_reference loadedImage, images )
+	{
+		boost::shared_ptr<ImageHolder> imageHolder = addImageHolder ( loadedImage );
+		checkForCaCp ( imageHolder );
+
+		if ( ! ( getMode() == ViewerCoreBase::zmap && imageHolder->imageType == ImageHolder::structural_image ) )
+		{
+			if ( fileInfo.isNewEnsemble() )
 			{
-				if ( fileInfo.isNewEnsemble() )
+				ensemble = getUICore()->createViewWidgetEnsemble ( "" );
+
+				//if we load a zmap we additionally add an anatomical image to the widget to make things easier for the user....
+				if ( fileInfo.getImageType() == ImageHolder::z_map && m_CurrentAnatomicalReference.get() )
 				{
-					ensemble = getUICore()->createViewWidgetEnsemble ( "" );
-
-					//if we load a zmap we additionally add an anatomical image to the widget to make things easier for the user....
-					if ( fileInfo.getImageType() == ImageHolder::z_map && m_CurrentAnatomicalReference.get() )
-					{
-						attachImageToWidget ( m_CurrentAnatomicalReference, ensemble[0].widgetImplementation );
-						attachImageToWidget ( m_CurrentAnatomicalReference, ensemble[1].widgetImplementation );
-						attachImageToWidget ( m_CurrentAnatomicalReference, ensemble[2].widgetImplementation );
-					}
+					attachImageToWidget ( m_CurrentAnatomicalReference, ensemble[0].widgetImplementation );
+					attachImageToWidget ( m_CurrentAnatomicalReference, ensemble[1].widgetImplementation );
+					attachImageToWidget ( m_CurrentAnatomicalReference, ensemble[2].widgetImplementation );
 				}
-
-				attachImageToWidget ( imageHolder, ensemble[0].widgetImplementation );
-				attachImageToWidget ( imageHolder, ensemble[1].widgetImplementation );
-				attachImageToWidget ( imageHolder, ensemble[2].widgetImplementation );
-				setCurrentImage ( imageHolder );
 			}
+
+			attachImageToWidget ( imageHolder, ensemble[0].widgetImplementation );
+			attachImageToWidget ( imageHolder, ensemble[1].widgetImplementation );
+			attachImageToWidget ( imageHolder, ensemble[2].widgetImplementation );
+			setCurrentImage ( imageHolder );
 		}
-		getUICore()->rearrangeViewWidgets();
-		getUICore()->refreshUI();
-		centerImages();
-		getUICore()->getMainWindow()->toggleLoadingIcon( false );
 	}
-	
+	getUICore()->rearrangeViewWidgets();
+	getUICore()->refreshUI();
+	centerImages();
 }
 
 void QViewerCore::closeImage ( boost::shared_ptr<ImageHolder> image, bool refreshUI )
@@ -453,6 +609,8 @@ void QViewerCore::loadSettings()
 	getOptionMap()->setPropertyAs<bool> ( "showCrosshair", getSettings()->value ( "showCrosshair", true ).toBool() );
 	getOptionMap()->setPropertyAs<uint16_t> ( "minMaxSearchRadius",
 			getSettings()->value ( "minMaxSearchRadius", getOptionMap()->getPropertyAs<uint16_t> ( "minMaxSearchRadius" ) ).toUInt() );
+	getOptionMap()->setPropertyAs<bool> ( "minMaxSearchAllTimesteps", getSettings()->value ( "minMaxSearchAllTimesteps", false ).toBool() );
+	getOptionMap()->setPropertyAs<bool> ( "highPrecisionStructural", getSettings()->value ( "highPrecisionStructural", false ).toBool() );
 	getOptionMap()->setPropertyAs<bool> ( "showAdvancedFileDialogOptions", getSettings()->value ( "showAdvancedFileDialogOptions", false ).toBool() );
 	getOptionMap()->setPropertyAs<bool> ( "showFavoriteFileList", getSettings()->value ( "showFavoriteFileList", false ).toBool() );
 	getOptionMap()->setPropertyAs<bool> ( "showStartWidget", getSettings()->value ( "showStartWidget", true ).toBool() );
@@ -462,6 +620,8 @@ void QViewerCore::loadSettings()
 	getOptionMap()->setPropertyAs<bool> ( "useAllAvailablethreads", getSettings()->value ( "useAllAvailableThreads" ).toBool() );
 	getOptionMap()->setPropertyAs<bool> ( "histogramOmitZero", getSettings()->value ( "histogramOmitZero" ).toBool() );
 	getOptionMap()->setPropertyAs<bool>( "visualizeOnlyFirstVista", getSettings()->value( "visualizeOnlyFirstVista", getOptionMap()->getPropertyAs<bool>("visualizeOnlyFirstVista") ).toBool() );
+	getOptionMap()->setPropertyAs<uint16_t> ( "maxResidentVolumes", getSettings()->value ( "maxResidentVolumes", getOptionMap()->getPropertyAs<uint16_t> ( "maxResidentVolumes" ) ).toUInt() );
+	getOptionMap()->setPropertyAs<uint16_t> ( "prefetchVolumes", getSettings()->value ( "prefetchVolumes", getOptionMap()->getPropertyAs<uint16_t> ( "prefetchVolumes" ) ).toUInt() );
 	//screenshot stuff
 	getOptionMap()->setPropertyAs<uint16_t> ( "screenshotWidth", getSettings()->value ( "screenshotWidth", getOptionMap()->getPropertyAs<uint16_t> ( "screenshotWidth" ) ).toUInt() );
 	getOptionMap()->setPropertyAs<uint16_t> ( "screenshotHeight", getSettings()->value ( "screenshotHeight", getOptionMap()->getPropertyAs<uint16_t> ( "screenshotHeight" ) ).toUInt() );
@@ -488,6 +648,8 @@ void QViewerCore::saveSettings()
 	getSettings()->setValue ( "interpolationType", getOptionMap()->getPropertyAs<uint16_t> ( "interpolationType" ) );
 	getSettings()->setValue ( "propagateZooming", getOptionMap()->getPropertyAs<bool> ( "propagateZooming" ) );
 	getSettings()->setValue ( "minMaxSearchRadius", getOptionMap()->getPropertyAs<uint16_t> ( "minMaxSearchRadius" ) );
+	getSettings()->setValue ( "minMaxSearchAllTimesteps", getOptionMap()->getPropertyAs<bool> ( "minMaxSearchAllTimesteps" ) );
+	getSettings()->setValue ( "highPrecisionStructural", getOptionMap()->getPropertyAs<bool> ( "highPrecisionStructural" ) );
 	getSettings()->setValue ( "showLabels", getOptionMap()->getPropertyAs<bool> ( "showLabels" ) );
 	getSettings()->setValue ( "showCrosshair", getOptionMap()->getPropertyAs<bool> ( "showCrosshair" ) );
 	getSettings()->setValue ( "showAdvancedFileDialogOptions", getOptionMap()->getPropertyAs<bool> ( "showAdvancedFileDialogOptions" ) );
@@ -498,6 +660,8 @@ void QViewerCore::saveSettings()
 	getSettings()->setValue ( "enableMultithreading", getOptionMap()->getPropertyAs<bool> ( "enableMultithreading" ) );
 	getSettings()->setValue ( "useAllAvailablethreads", getOptionMap()->getPropertyAs<bool> ( "useAllAvailableThreads" ) );
 	getSettings()->setValue ( "histogramOmitZero", getOptionMap()->getPropertyAs<bool> ( "histogramOmitZero" ) );
+	getSettings()->setValue ( "maxResidentVolumes", getOptionMap()->getPropertyAs<uint16_t> ( "maxResidentVolumes" ) );
+	getSettings()->setValue ( "prefetchVolumes", getOptionMap()->getPropertyAs<uint16_t> ( "prefetchVolumes" ) );
 	//screenshot stuff
 	getSettings()->setValue ( "screenshotWidth", getOptionMap()->getPropertyAs<uint16_t> ( "screenshotWidth" ) );
 	getSettings()->setValue ( "screenshotHeight", getOptionMap()->getPropertyAs<uint16_t> ( "screenshotHeight" ) );
@@ -515,6 +679,7 @@ void QViewerCore::saveSettings()
 
 void QViewerCore::close ()
 {
+	cancelLoading();
 	getSettings()->beginGroup("ErrorHandling");
 	getSettings()->setValue( "vastExitedSuccessfully", true );
 	getSettings()->sync();
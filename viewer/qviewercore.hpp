@@ -35,6 +35,7 @@
 #include "qprogressfeedback.hpp"
 
 #include <QtGui>
+#include <QFutureWatcher>
 #include <Adapter/qtapplication.hpp>
 
 
@@ -89,6 +90,22 @@ public:
 	isis::viewer::_internal::FileInformationMap &getRecentFiles() { return m_RecentFiles; }
 	isis::viewer::_internal::FileInformationMap &getFavFiles() { return m_FavFiles; }
 
+	///true as long as images opened with openPath are loaded in the background
+	bool isLoading() const { return !m_PendingLoads.empty(); }
+
+	/**
+	 * Loads the files and creates their image holders without adding them to the core.
+	 * Can be called from a worker thread. If canceled is set while loading, an empty list is returned.
+	 * If parallel is false the images are converted without OpenMP, so several of these calls can run next to each other.
+	 */
+	static ImageHolder::ImageListType loadImages( const _internal::FileInformation fileInfo, const size_t maxResidentVolumes, const bool highPrecision,
+			boost::shared_ptr<QAtomicInt> canceled = boost::shared_ptr<QAtomicInt>(), const bool parallel = true );
+	/**
+	 * Loads all files concurrently with at most numberOfThreads worker threads and blocks until all of them are loaded.
+	 * The returned image lists are in the order of fileList. The images still have to be added with addImageHolder.
+	 */
+	std::vector<ImageHolder::ImageListType> loadFiles( const std::list<_internal::FileInformation> &fileList );
+
 
 public Q_SLOTS:
 	virtual void settingsChanged();
@@ -96,6 +113,8 @@ public Q_SLOTS:
 	virtual void zoomChanged( float zoomFactor );
 	virtual void physicalCoordsChanged( util::fvector4 );
 	virtual void timestepChanged( int );
+	///converts the volumes and extracts the slices of the count timesteps following timestep in the background
+	virtual void prefetchTimesteps( int timestep, int count );
 	virtual void setShowLabels( bool );
 	virtual void setShowCrosshair( bool );
 	virtual void updateScene( );
@@ -103,7 +122,13 @@ public Q_SLOTS:
 	virtual void receiveMessage( qt4::QMessage  );
 	virtual void receiveMessage( std::string  );
 	virtual void receiveMessageDev( qt4::QMessage );
+	/**
+	 * Loads the image in the background. Loading, conversion of the first volume and its histogram are done by a worker thread.
+	 * The image is added to the widgets as soon as this is finished, the remaining volumes are converted afterwards.
+	 */
 	virtual void openPath( const _internal::FileInformation& );
+	///discards all images that are still loaded by openPath
+	virtual void cancelLoading();
 	virtual void centerImages( bool ca = false );
 	virtual void closeImage( boost::shared_ptr<ImageHolder> image, bool refreshUI = true );
 	virtual void saveSettings();
@@ -119,9 +144,22 @@ Q_SIGNALS:
 	void emitShowLabels( bool );
 	void emitUpdateScene( );
 	void emitSetEnableCrosshair( bool enable );
+	void emitPrefetchTimesteps( int timestep, int count );
+
+private Q_SLOTS:
+	void loadingFinished();
 
 private:
 
+	struct PendingLoad {
+		PendingLoad( const _internal::FileInformation &info ) : fileInfo( info ), watcher( 0 ) {}
+		_internal::FileInformation fileInfo;
+		QFutureWatcher<ImageHolder::ImageListType> *watcher;
+		boost::shared_ptr<QAtomicInt> canceled;
+	};
+
+	void addLoadedImages( const _internal::FileInformation &fileInfo, const ImageHolder::ImageListType &images );
+
 	void checkForErrors();
 	
 	QSettings *m_Settings;
@@ -136,6 +174,9 @@ private:
 	
     _internal::FileInformationMap m_RecentFiles;
 	_internal::FileInformationMap m_FavFiles;
+
+	//loads started by openPath in the order they were started
+	std::list<PendingLoad> m_PendingLoads;
 	
 
 };
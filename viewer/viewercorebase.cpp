@@ -65,7 +65,15 @@ ImageHolder::ImageListType ViewerCoreBase::addImageList( const std::list< data::
 
 boost::shared_ptr<ImageHolder> ViewerCoreBase::addImage( const isis::data::Image &image, const isis::viewer::ImageHolder::ImageType &imageType )
 {
-	boost::shared_ptr<ImageHolder> retImage = m_DataContainer.addImage( image, imageType );
+	return addImageHolder( DataContainer::createImageHolder( image, imageType, getOptionMap()->getPropertyAs<uint16_t>( "maxResidentVolumes" ),
+						   getOptionMap()->getPropertyAs<bool>( "highPrecisionStructural" ) ) );
+}
+
+boost::shared_ptr<ImageHolder> ViewerCoreBase::addImageHolder( boost::shared_ptr<ImageHolder> retImage )
+{
+	const ImageHolder::ImageType imageType = retImage->imageType;
+	m_DataContainer.insertImageHolder( retImage );
+	retImage->prefetchVolumes( 0, getOptionMap()->getPropertyAs<uint16_t>( "prefetchVolumes" ) );
 
 	//setting the lutStructural
 	if( imageType == ImageHolder::structural_image ) {
@@ -87,7 +95,7 @@ boost::shared_ptr<ImageHolder> ViewerCoreBase::addImage( const isis::data::Image
 
 	retImage->updateColorMap();
 
-	if( imageType == ImageHolder::structural_image && image.getSizeAsVector()[3] == 1 ) {
+	if( imageType == ImageHolder::structural_image && retImage->getImageSize()[3] == 1 ) {
 		m_CurrentAnatomicalReference = retImage;
 	}
 
@@ -147,6 +155,7 @@ void ViewerCoreBase::setCommonViewerOptions()
 	m_OptionsMap->setPropertyAs<bool>( "showLables", false );
 	m_OptionsMap->setPropertyAs<bool>( "showCrosshair", true );
 	m_OptionsMap->setPropertyAs<uint16_t>( "minMaxSearchRadius", 20 );
+	m_OptionsMap->setPropertyAs<bool>( "minMaxSearchAllTimesteps", false );
 	m_OptionsMap->setPropertyAs<bool>( "showAdvancedFileDialogOptions", false );
 	m_OptionsMap->setPropertyAs<bool>( "showFavoriteFileList", false );
 	m_OptionsMap->setPropertyAs<uint16_t>( "maxWidgetHeight", 200 );
@@ -178,6 +187,9 @@ void ViewerCoreBase::setCommonViewerOptions()
 	m_OptionsMap->setPropertyAs<std::string>( "lutZMap", "standard_zmap" );
 	//misc
 	m_OptionsMap->setPropertyAs<uint16_t>( "timeseriesPlayDelayTime", 50 );
+	m_OptionsMap->setPropertyAs<uint16_t>( "maxResidentVolumes", 200 );
+	m_OptionsMap->setPropertyAs<uint16_t>( "prefetchVolumes", 8 );
+	m_OptionsMap->setPropertyAs<bool>( "highPrecisionStructural", false );
 	m_OptionsMap->setPropertyAs<bool>( "histogramOmitZero", true );
 	m_OptionsMap->setPropertyAs<uint16_t>("maxRecentOpenListSize", 10 );
 	//logging
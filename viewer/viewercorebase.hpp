@@ -57,6 +57,8 @@ public:
 	virtual ImageHolder::ImageListType addImageList( const std::list< data::Image > imageList, const ImageHolder::ImageType &imageType );
 	virtual void setImageList( const std::list< data::Image > imageList, const ImageHolder::ImageType &imageType );
 	virtual boost::shared_ptr<ImageHolder> addImage( const data::Image &image, const ImageHolder::ImageType &imageType );
+	///adds an image holder that was already created by DataContainer::createImageHolder, e.g. by a worker thread
+	virtual boost::shared_ptr<ImageHolder> addImageHolder( boost::shared_ptr<ImageHolder> imageHolder );
 
 	void setCurrentImage( const boost::shared_ptr<ImageHolder> image ) { m_CurrentImage = image; }
 
@@ -55,7 +55,28 @@ void ImageStack::contextMenuEvent( QContextMenuEvent *event )
 	menu.addAction( m_Widget->m_Interface.actionDistribute_images );
 	menu.addSeparator();
 	menu.addAction( m_Widget->m_Interface.actionClose_all_images );
-	menu.exec( event->globalPos() );
+	//the precision can be chosen for every structural image
+	QListWidgetItem *item = itemAt( event->pos() );
+	boost::shared_ptr<ImageHolder> image;
+	QAction *highPrecisionAction = 0;
+
+	if( item && m_Widget->m_ViewerCore->getDataContainer().find( item->text().toStdString() ) != m_Widget->m_ViewerCore->getDataContainer().end() ) {
+		image = m_Widget->m_ViewerCore->getDataContainer().at( item->text().toStdString() );
+
+		if( !image->isRGB && image->imageType == ImageHolder::structural_image ) {
+			menu.addSeparator();
+			highPrecisionAction = menu.addAction( tr( "High precision (16 bit)" ) );
+			highPrecisionAction->setCheckable( true );
+			highPrecisionAction->setChecked( image->isHighPrecision() );
+		}
+	}
+
+	const QAction *chosenAction = menu.exec( event->globalPos() );
+
+	if( highPrecisionAction && chosenAction == highPrecisionAction ) {
+		image->setHighPrecision( highPrecisionAction->isChecked() );
+		m_Widget->m_ViewerCore->updateScene();
+	}
 }
 
 void ImageStack::mousePressEvent( QMouseEvent *e )
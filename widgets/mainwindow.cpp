@@ -54,7 +54,8 @@ MainWindow::MainWindow( QViewerCore *core ) :
 	m_RadiusSpin( new QSpinBox( this ) ),
 	m_StatusTextLabel( new QLabel( this ) ),
 	m_StatusMovieLabel( new QLabel(this ) ),
-	m_StatusMovie( new QMovie( this ) )
+	m_StatusMovie( new QMovie( this ) ),
+	m_StatusCancelButton( new QToolButton( this ) )
 {
 	m_Interface.setupUi( this );
 	setWindowIcon( QIcon( m_ViewerCore->getOptionMap()->getPropertyAs<std::string>("vastSymbol").c_str() ) );
@@ -148,6 +149,11 @@ MainWindow::MainWindow( QViewerCore *core ) :
 	m_StatusMovie->setScaledSize(QSize( m_Interface.statusbar->height(), m_Interface.statusbar->height() ) );
 	m_StatusMovieLabel->setMovie( m_StatusMovie );
 	m_StatusMovieLabel->setVisible( false );
+	m_Interface.statusbar->insertPermanentWidget(2, m_StatusCancelButton );
+	m_StatusCancelButton->setText( tr( "Cancel" ) );
+	m_StatusCancelButton->setToolTip( "Cancel loading of the images that are opened right now. A file that is being read is still read completely, only its conversion is skipped." );
+	m_StatusCancelButton->setVisible( false );
+	connect( m_StatusCancelButton, SIGNAL( clicked() ), m_ViewerCore, SLOT( cancelLoading() ) );
 	m_Interface.statusbar->setVisible(false);
 	
 	
@@ -164,6 +170,7 @@ void MainWindow::toggleLoadingIcon ( bool start, const QString &text )
 		m_ViewerCore->receiveMessage( text.toStdString() );
 	}
 	m_StatusMovieLabel->setVisible(start);
+	m_StatusCancelButton->setVisible( start && m_ViewerCore->isLoading() );
 	m_Interface.statusbar->setVisible( start );
 	if( start ) {
 		m_StatusMovie->start();
@@ -575,7 +582,13 @@ void MainWindow::findGlobalMin()
 		}
 		const util::ivector4 minVoxel = operation::NativeImageOps::getGlobalMin( m_ViewerCore->getCurrentImage(),
 										m_ViewerCore->getCurrentImage()->voxelCoords,
-										radius );
+										radius,
+										m_ViewerCore->getOptionMap()->getPropertyAs<bool>( "minMaxSearchAllTimesteps" ) );
+
+		if( minVoxel[3] != m_ViewerCore->getCurrentImage()->voxelCoords[3] ) {
+			m_ViewerCore->timestepChanged( minVoxel[3] );
+		}
+
 		m_ViewerCore->physicalCoordsChanged( m_ViewerCore->getCurrentImage()->getISISImage()->getPhysicalCoordsFromIndex( minVoxel ) );
 		toggleLoadingIcon(false);
 	}
@@ -590,7 +603,13 @@ void MainWindow::findGlobalMax()
 		}
 		const util::ivector4 maxVoxel = operation::NativeImageOps::getGlobalMax( m_ViewerCore->getCurrentImage(),
 										m_ViewerCore->getCurrentImage()->voxelCoords,
-										radius );
+										radius,
+										m_ViewerCore->getOptionMap()->getPropertyAs<bool>( "minMaxSearchAllTimesteps" ) );
+
+		if( maxVoxel[3] != m_ViewerCore->getCurrentImage()->voxelCoords[3] ) {
+			m_ViewerCore->timestepChanged( maxVoxel[3] );
+		}
+
 		m_ViewerCore->physicalCoordsChanged( m_ViewerCore->getCurrentImage()->getISISImage()->getPhysicalCoordsFromIndex( maxVoxel ) );
 		toggleLoadingIcon(false);
 	}
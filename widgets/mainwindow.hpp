@@ -126,6 +126,7 @@ private:
 
 	QLabel * m_StatusMovieLabel;
 	QMovie * m_StatusMovie;
+	QToolButton *m_StatusCancelButton;
 
 
 };
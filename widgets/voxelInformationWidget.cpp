@@ -49,7 +49,7 @@ VoxelInformationWidget::VoxelInformationWidget( QWidget *parent, QViewerCore *co
 	m_Interface.sliceBox->setMinimum( 0 );
 	m_Interface.upperHalfColormapLabel->setMaximumHeight( 20 );
 	m_Interface.playButton->setIcon( QIcon( ":/common/play.png" ) );
-	m_tThread = new TimePlayThread( m_ViewerCore, &m_Interface );
+	m_PlayTimer = new QTimer( this );
 
 }
 
@@ -90,7 +90,7 @@ void VoxelInformationWidget::connectSignals()
 	connect( m_Interface.timestepSpinBox, SIGNAL( valueChanged( int ) ), m_ViewerCore, SLOT( timestepChanged( int ) ) );
 	connect( m_Interface.timestepSlider, SIGNAL( sliderMoved( int ) ), m_Interface.timestepSpinBox, SLOT( setValue( int ) ) );
 	connect( m_Interface.timestepSpinBox, SIGNAL( valueChanged( int ) ), m_Interface.timestepSlider, SLOT( setValue( int ) ) );
-	connect( m_tThread, SIGNAL( finished() ), this, SLOT( timePlayFinished() ) );
+	connect( m_PlayTimer, SIGNAL( timeout() ), this, SLOT( playNextTimestep() ) );
 	connect( m_Interface.playButton, SIGNAL( clicked() ), this, SLOT( playTimecourse() ) );
 	isConnected = true;
 }
@@ -106,24 +106,78 @@ void VoxelInformationWidget::updateLowerUpperThreshold()
 void VoxelInformationWidget::playTimecourse()
 {
 	if( m_ViewerCore->hasImage() ) {
-		if( m_tThread->isRunning() ) {
-			m_tThread->terminate();
-			m_Interface.playButton->setIcon( QIcon( ":/common/play.png" ) );
+		if( m_PlayTimer->isActive() ) {
+			timePlayFinished();
 		} else {
-			if ( QApplication::keyboardModifiers() == Qt::ControlModifier ) {
-				m_tThread->setStartStop( 0, m_ViewerCore->getCurrentImage()->getImageSize()[3] );
-			} else {
-				m_tThread->setStartStop( m_Interface.timestepSlider->value(), m_ViewerCore->getCurrentImage()->getImageSize()[3] );
+			m_PlayStart = QApplication::keyboardModifiers() == Qt::ControlModifier ? 0 : m_Interface.timestepSlider->value();
+			m_PlayedFrames = 0;
+			m_DroppedFrames = 0;
+			m_ViewerCore->prefetchTimesteps( m_PlayStart, m_ViewerCore->getOptionMap()->getPropertyAs<uint16_t>( "prefetchVolumes" ) );
+			m_Interface.playButton->setIcon( QIcon( ":/common/pause.png" ) );
+			m_PlayClock.start();
+			m_PlayTimer->start( m_ViewerCore->getOptionMap()->getPropertyAs<uint16_t>( "timeseriesPlayDelayTime" ) );
+		}
+	}
+}
+
+void VoxelInformationWidget::playNextTimestep()
+{
+	const int nTimesteps = m_ViewerCore->hasImage() ? m_ViewerCore->getCurrentImage()->getImageSize()[3] : 0;
+
+	if( nTimesteps < 2 ) {
+		timePlayFinished();
+		return;
+	}
+
+	//the shown timestep follows the wall clock, so frames that are not ready in time are dropped instead of slowing down the playback
+	const int delayTime = std::max<int>( 1, m_ViewerCore->getOptionMap()->getPropertyAs<uint16_t>( "timeseriesPlayDelayTime" ) );
+	const int prefetch = m_ViewerCore->getOptionMap()->getPropertyAs<uint16_t>( "prefetchVolumes" );
+	const int current = m_Interface.timestepSlider->value();
+	const int timestep = ( m_PlayStart + m_PlayClock.elapsed() / delayTime ) % nTimesteps;
+
+	if( timestep == current ) {
+		return;
+	}
+
+	BOOST_FOREACH( DataContainer::const_reference image, m_ViewerCore->getDataContainer() ) {
+		if( image.second->isVisible && static_cast<size_t>( timestep ) < image.second->getImageSize()[3] && !image.second->isVolumeResident( timestep ) ) {
+			const size_t maxResident = image.second->getMaxResidentVolumes();
+
+			if( prefetch && ( !maxResident || maxResident > 1 ) ) {
+				//make sure the volume is on its way and try again with the next tick
+				m_ViewerCore->prefetchTimesteps( ( timestep + nTimesteps - 1 ) % nTimesteps, prefetch );
+				return;
 			}
 
-			m_Interface.playButton->setIcon( QIcon( ":/common/pause.png" ) );
-			m_tThread->start();
+			//no prefetch will ever cover this volume, so convert it right away
+			image.second->getVolume( timestep );
 		}
 	}
+	m_DroppedFrames += ( timestep - current + nTimesteps ) % nTimesteps - 1;
+	m_PlayedFrames++;
+	m_Interface.timestepSlider->setValue( timestep );
+	m_Interface.timestepSpinBox->setValue( timestep );
+	m_ViewerCore->prefetchTimesteps( timestep, prefetch );
+
+	if( m_PlayClock.elapsed() ) {
+		std::stringstream fps;
+		fps << roundNumber<double>( m_PlayedFrames * 1000.0 / m_PlayClock.elapsed(), 2 ) << " fps, "
+			<< m_DroppedFrames << " frames dropped";
+		m_Interface.playButton->setToolTip( fps.str().c_str() );
+	}
 }
 
 void VoxelInformationWidget::timePlayFinished()
 {
+	if( m_PlayTimer->isActive() ) {
+		m_PlayTimer->stop();
+
+		if( m_PlayClock.elapsed() ) {
+			LOG( Runtime, notice ) << "Played " << m_PlayedFrames << " frames in " << m_PlayClock.elapsed() / 1000.0 << " seconds ("
+								   << m_PlayedFrames * 1000.0 / m_PlayClock.elapsed() << " fps). " << m_DroppedFrames << " frames were dropped.";
+		}
+	}
+
 	m_Interface.playButton->setIcon( QIcon( ":/common/play.png" ) );
 }
 
@@ -31,7 +31,8 @@
 #include "ui_voxelInformationWidget.h"
 #include "common.hpp"
 #include "qviewercore.hpp"
-#include <QThread>
+#include <QTimer>
+#include <QTime>
 
 namespace isis
 {
@@ -44,32 +45,6 @@ namespace widget
 class VoxelInformationWidget : public QWidget
 {
 	Q_OBJECT
-	class TimePlayThread : public QThread
-	{
-		QViewerCore *m_core;
-		int m_start;
-		int m_end;
-		Ui::voxelInformationWidget *m_interface;
-
-	public:
-		TimePlayThread( QViewerCore *core, Ui::voxelInformationWidget *interface ) : m_core( core ), m_start( 0 ), m_end( 0 ), m_interface( interface ) {} ;
-		void setStartStop( int start, int stop ) { m_start = start; m_end = stop; }
-		void run() {
-			uint16_t deleyTime = m_core->getOptionMap()->getPropertyAs<uint16_t>( "timeseriesPlayDelayTime" );
-			uint16_t t = m_start;
-
-			while( true ) {
-				t = t == m_end ? 0 : t;
-				msleep( deleyTime );
-				m_interface->timestepSlider->setValue( t );
-				m_interface->timestepSpinBox->setValue( t );
-				QApplication::processEvents();
-				t++;
-
-			}
-		}
-	};
-
 public:
 	VoxelInformationWidget( QWidget *parent, QViewerCore *core );
 
@@ -83,6 +58,7 @@ public Q_SLOTS:
 	void physPosChanged();
 	void updateLowerUpperThreshold(  );
 	void playTimecourse();
+	void playNextTimestep();
 	void timePlayFinished();
 
 private:
@@ -92,7 +68,11 @@ private:
 	void connectSignals();
 	void disconnectSignals();
 	void reconnectSignals();
-	TimePlayThread *m_tThread;
+	QTimer *m_PlayTimer;
+	QTime m_PlayClock;
+	int m_PlayStart;
+	int m_PlayedFrames;
+	int m_DroppedFrames;
 
 	template<typename TYPE>
 	void displayIntensity( const util::ivector4 &coords ) const {